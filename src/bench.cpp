@@ -0,0 +1,317 @@
+/***************************************************************************
+ * Brutal Chess
+ * http://brutalchess.sf.net
+ *
+ * File : bench.cpp
+ * Authors : Mike Cook, Joe Flint, Neil Pankey
+ **************************************************************************/
+
+#include "board.h"
+#include "chessgamestate.h"
+#include "chessplayer.h"
+#include "options.h"
+#include "transtable.h"
+#include "SDL.h"
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Middlegame positions with plenty to search
+static const char * const SMP_POSITIONS[] = {
+	"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+	"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+	"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+	"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+	"r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4",
+	"r2q1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP2BPPP/R2Q1RK1 w - - 0 9"
+};
+
+static const int NUM_SMP_POSITIONS = sizeof(SMP_POSITIONS) / sizeof(SMP_POSITIONS[0]);
+
+// Openings, middlegames and endgames for the node count signature. Changing
+// this list changes the signature, so add to it rather than editing it.
+static const char * const SIGNATURE_POSITIONS[] = {
+	"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+	"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 10",
+	"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 11",
+	"4rrk1/pp1n3p/3q2pQ/2p1pb2/2PP4/2P3N1/P2B2PP/4RRK1 b - - 7 19",
+	"rq3rk1/ppp2ppp/1bnpb3/3N2B1/3NP3/7P/PPPQ1PP1/2KR3R w - - 7 14",
+	"r1bq1r1k/1pp1n1pp/1p1p4/4p2Q/4Pp2/1BNP4/PPP2PPP/3R1RK1 w - - 2 14",
+	"r3r1k1/2p2ppp/p1p1bn2/8/1q2P3/2NPQN2/PPP3PP/R4RK1 b - - 2 15",
+	"r1bbk1nr/pp3p1p/2n5/1N4p1/2Np1B2/8/PPP2PPP/2KR1B1R w kq - 0 13",
+	"r1bq1rk1/ppp1nppp/4n3/3p3Q/3P4/1BP1B3/PP1N2PP/R4RK1 w - - 1 16",
+	"4r1k1/r1q2ppp/ppp2n2/4P3/5Rb1/1N1BQ3/PPP3PP/R5K1 w - - 1 17",
+	"2rqkb1r/ppp2p2/2npb1p1/1N1Nn2p/2P1PP2/8/PP2B1PP/R1BQK2R b KQ - 0 11",
+	"r1bq1r1k/b1p1npp1/p2p3p/1p6/3PP3/1B2NN2/PP3PPP/R2Q1RK1 w - - 1 16",
+	"3r1rk1/p5pp/bpp1pp2/8/q1PP1P2/b3P3/P2NQRPP/1R2B1K1 b - - 6 22",
+	"r1q2rk1/2p1bppp/2Pp4/p6b/Q1PNp3/4B3/PP1R1PPP/2K4R w - - 2 18",
+	"4k2r/1pb2ppp/1p2p3/1R1p4/3P4/2r1PN2/P4PPP/1R4K1 b - - 3 22",
+	"3q2k1/pb3p1p/4pbp1/2r5/PpN2N2/1P2P2P/5PP1/Q2R2K1 b - - 4 26",
+	"6k1/6p1/6Pp/ppp5/3pn2P/1P3K2/1PP2P2/8 b - - 0 1",
+	"3b4/5kp1/1p1p1p1p/pP1PpP1P/P1P1P3/3KN3/8/8 w - - 0 1",
+	"2K5/p7/7P/5pR1/8/5k2/r7/8 w - - 0 1",
+	"8/6pk/1p6/8/PP3p1p/5P2/4KP1q/3Q4 w - - 0 1",
+	"7k/3p2pp/4q3/8/4Q3/5Kp1/P6b/8 w - - 0 1",
+	"8/2p5/8/2kPKp1p/2p4P/2P5/3P4/8 w - - 0 1",
+	"8/1p3pp1/7p/5P1P/2k3P1/8/2K2P2/8 w - - 0 1",
+	"8/pp2r1k1/2p1p3/3pP2p/1P1P1P1P/P5KR/8/8 w - - 0 1",
+	"8/3p4/p1bk3p/Pp6/1Kp1PpPp/2P2P1P/2P5/5B2 b - - 0 1",
+	"5k2/7R/4P2p/5K2/p1r2P1p/8/8/8 b - - 0 1",
+	"6k1/6p1/P6p/r1N5/5p2/7P/1b3PP1/4R1K1 w - - 0 1",
+	"1r3k2/4q3/2Pp3b/3Bp3/2Q2p2/1p1P2P1/1P2KP2/3N4 w - - 0 1",
+	"6k1/4pp1p/3p2p1/P1pPb3/R7/1r2P1PP/3B1P2/6K1 w - - 0 1",
+	"8/3p3B/5p2/5P2/p7/PP5b/k7/6K1 w - - 0 1",
+	"5rk1/q6p/2p3bR/1pPp1rP1/1P1Pp3/P3B1Q1/1K3P2/R7 w - - 93 90",
+	"4rrk1/1p1nq3/p7/2p1P1pp/3P2bp/3Q1Bn1/PPPB4/1K2R1NR w - - 40 21",
+	"r3k2r/3nnpbp/q2pp1p1/p7/Pp1PPPP1/4BNN1/1P5P/R2Q1RK1 w kq - 0 16",
+	"3Qb1k1/1r2ppb1/pN1n2q1/Pp1Pp1Pr/4P2p/4BP2/4B1R1/1R5K b - - 11 40",
+	"4k3/3q1r2/1N2r1b1/3ppN2/2nPP3/1B1R2n1/2R1Q3/3K4 w - - 5 1",
+	"8/8/8/8/5kp1/P7/8/1K1N4 w - - 0 1",
+	"8/8/8/5N2/8/p7/8/2NK3k w - - 0 1",
+	"8/3k4/8/8/8/4B3/4KB2/2B5 w - - 0 1",
+	"8/8/1P6/5pr1/8/4R3/7k/2K5 w - - 0 1",
+	"8/2p4P/8/kr6/6R1/8/8/1K6 w - - 0 1"
+};
+
+static const int NUM_SIGNATURE_POSITIONS = sizeof(SIGNATURE_POSITIONS) / sizeof(SIGNATURE_POSITIONS[0]);
+
+void printBenchUsage()
+{
+	cerr << "Usage: brutalbench [--depth=PLY] [--hash=MB] [--lines=N] [--net=FILE] [--threads=N,N,...]" << endl;
+	cerr << "       brutalbench --signature [--depth=PLY] [--hash=MB] [--net=FILE]" << endl;
+#ifndef NDEBUG
+	cerr << "       brutalbench --eval" << endl;
+#endif
+	cerr << endl;
+	cerr << " --depth=PLY\t\t Search depth for every position, 4 by default." << endl;
+	cerr << " --hash=MB\t\t Transposition table size, 16 by default." << endl;
+	cerr << " --lines=N\t\t Best moves to find in each position, 1 by default." << endl;
+	cerr << " --net=FILE\t\t Evaluate with the neural network weights in FILE." << endl;
+	cerr << " --threads=N,N,...\t Thread counts to time, 1,2,4,8,16 by default." << endl;
+	cerr << " --signature\t\t Search a fixed set of positions on one thread and" << endl;
+	cerr << "\t\t\t print the node count and speed, 5 ply by default." << endl;
+#ifndef NDEBUG
+	cerr << " --eval\t\t\t Print the terms of the static evaluation of each" << endl;
+	cerr << "\t\t\t signature position." << endl;
+#endif
+	exit(1);
+}
+
+// Searches every position to the given depth, returns the combined
+// statistics with the time taken in ms
+SearchStats timeToDepth(int threads, int depth, int hash, int lines)
+{
+	SearchStats total;
+	Uint32 elapsed = 0;
+
+	for(int i = 0; i < NUM_SMP_POSITIONS; i++) {
+		ChessGameState cgs;
+		cgs.loadFEN(SMP_POSITIONS[i]);
+
+		BrutalPlayer player;
+		player.setIsWhite(cgs.isWhiteTurn());
+		player.setPly(depth);
+		player.setThreads(threads);
+		player.setHashSize(hash);
+		player.setUseBook(false);
+		player.setMultiPV(lines);
+
+		Uint32 start = SDL_GetTicks();
+		player.think(cgs);
+		elapsed += SDL_GetTicks() - start;
+		total += player.getSearchStats();
+	}
+
+	total.time = elapsed;
+	return total;
+}
+
+// Fills every entry of a small table, clears it and probes it again. Every
+// signature position starts from a cleared table, so anything left behind
+// would make the signature depend on the positions before it.
+bool tableClears()
+{
+	const int KEYS = (1 << 20) / 16 * 4;
+	TranspositionTable tt(1);
+
+	for(int i = 0; i < KEYS; i++) {
+		tt.store((i + 1) * 0x9E3779B97F4A7C15ULL, 1, i, TranspositionTable::EXACT,
+		         TranspositionTable::NO_MOVE);
+	}
+	tt.clear();
+
+	for(int i = 0; i < KEYS; i++) {
+		int depth, score, move;
+		TranspositionTable::Bound bound;
+		if(tt.probe((i + 1) * 0x9E3779B97F4A7C15ULL, depth, score, bound, move)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Searches every signature position to the given depth on a single thread,
+// printing the nodes of each and the totals. With nothing left to chance the
+// node count only changes when the search does, which makes it a signature
+// of the search, while the nodes per second measure its speed.
+void signature(int depth, int hash)
+{
+	SearchStats total;
+	Uint32 elapsed = 0;
+
+	for(int i = 0; i < NUM_SIGNATURE_POSITIONS; i++) {
+		ChessGameState cgs;
+		if(!cgs.loadFEN(SIGNATURE_POSITIONS[i])) {
+			cerr << "Bad position " << SIGNATURE_POSITIONS[i] << endl;
+			continue;
+		}
+
+		BrutalPlayer player;
+		player.setIsWhite(cgs.isWhiteTurn());
+		player.setPly(depth);
+		player.setThreads(1);
+		player.setHashSize(hash);
+		player.setUseBook(false);
+		player.setUseTablebases(false);
+		player.setMateSearch(0);
+		player.setPondering(false);
+
+		Uint32 start = SDL_GetTicks();
+		player.think(cgs);
+		elapsed += SDL_GetTicks() - start;
+		total += player.getSearchStats();
+
+		cout << "Position " << setw(2) << i + 1 << "/" << NUM_SIGNATURE_POSITIONS;
+		cout << setw(12) << player.getSearchStats().totalNodes() << endl;
+	}
+
+	total.time = elapsed;
+	cout << endl;
+	cout << "Depth          : " << depth << endl;
+	cout << "Hash (MB)      : " << hash << endl;
+	cout << "Time (ms)      : " << total.time << endl;
+	cout << "Nodes searched : " << total.totalNodes() << endl;
+	cout << "Nodes/second   : " << total.nps() << endl;
+}
+
+#ifndef NDEBUG
+// Prints the evaluation of every signature position term by term
+void evaluation()
+{
+	BrutalPlayer player;
+	for(int i = 0; i < NUM_SIGNATURE_POSITIONS; i++) {
+		ChessGameState cgs;
+		if(!cgs.loadFEN(SIGNATURE_POSITIONS[i])) {
+			cerr << "Bad position " << SIGNATURE_POSITIONS[i] << endl;
+			continue;
+		}
+
+		cout << SIGNATURE_POSITIONS[i] << endl;
+		player.printEvaluation(cout, cgs.getBoard(),
+		                       cgs.isWhiteTurn() ? Piece::WHITE : Piece::BLACK);
+		cout << endl;
+	}
+}
+#endif
+
+int main(int argc, char * argv[])
+{
+	int depth = 0, hash = 16, lines = 1;
+	bool sign = false, eval = false;
+	vector<int> threads;
+
+	for(int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		if(arg.substr(0, 8) == "--depth=") {
+			depth = atoi(arg.substr(8).c_str());
+		} else if(arg.substr(0, 7) == "--hash=") {
+			hash = atoi(arg.substr(7).c_str());
+		} else if(arg == "--signature") {
+			sign = true;
+#ifndef NDEBUG
+		} else if(arg == "--eval") {
+			eval = true;
+#endif
+		} else if(arg.substr(0, 8) == "--lines=") {
+			lines = atoi(arg.substr(8).c_str());
+		} else if(arg.substr(0, 6) == "--net=") {
+			Options::getInstance()->netfile = arg.substr(6);
+		} else if(arg.substr(0, 10) == "--threads=") {
+			string list = arg.substr(10);
+			string::size_type start = 0, comma;
+			do {
+				comma = list.find(',', start);
+				threads.push_back(atoi(list.substr(start, comma - start).c_str()));
+				start = comma + 1;
+			} while(comma != string::npos);
+		} else {
+			printBenchUsage();
+		}
+	}
+
+	if(threads.empty()) {
+		threads.push_back(1);
+		threads.push_back(2);
+		threads.push_back(4);
+		threads.push_back(8);
+		threads.push_back(16);
+	}
+
+	if(SDL_Init(SDL_INIT_TIMER) < 0) {
+		cerr << "Timer initialization failed: " << SDL_GetError() << endl;
+		return 1;
+	}
+	Board::init();
+
+#ifndef NDEBUG
+	if(eval) {
+		evaluation();
+		SDL_Quit();
+		return 0;
+	}
+#endif
+	if(sign) {
+		if(!tableClears()) {
+			cerr << "Transposition table isn't empty after a clear" << endl;
+			SDL_Quit();
+			return 1;
+		}
+		signature(depth ? depth : 5, hash);
+		SDL_Quit();
+		return 0;
+	}
+	if(depth == 0) {
+		depth = 4;
+	}
+
+	cout << "Time to depth " << depth << " over " << NUM_SMP_POSITIONS;
+	cout << " positions, " << hash << " MB hash";
+	if(lines > 1) {
+		cout << ", " << lines << " lines";
+	}
+	cout << endl;
+	cout << setw(8) << "threads" << setw(12) << "time (ms)" << setw(12) << "nodes";
+	cout << setw(10) << "nps" << setw(10) << "speedup" << endl;
+
+	Uint32 base = 0;
+	for(int i = 0; i < (int)threads.size(); i++) {
+		SearchStats stats = timeToDepth(threads[i], depth, hash, lines);
+		Uint32 elapsed = stats.time;
+		if(i == 0) {
+			base = elapsed;
+		}
+		cout << setw(8) << threads[i] << setw(12) << elapsed;
+		cout << setw(12) << stats.totalNodes() << setw(10) << stats.nps() << setw(10);
+		cout << fixed << setprecision(2) << (elapsed ? (double)base / elapsed : 0.0) << endl;
+	}
+
+	SDL_Quit();
+	return 0;
+}
+
+// End of file bench.cpp
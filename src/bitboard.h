@@ -61,6 +61,42 @@ class BitBoard {
 
 std::ostream& operator<< (std::ostream & os, const BitBoard & b);
 
+/**
+ * Returns the index (0-63) of the lowest set bit.
+ * @param b - A non-empty bit field.
+ */
+inline int bitScanForward(unsigned long long b)
+{
+#if defined(__GNUC__)
+	return __builtin_ctzll(b);
+#else
+	// De Bruijn multiplication, isolates the lowest bit and looks it up
+	static const int index[64] = {
+		 0,  1, 48,  2, 57, 49, 28,  3, 61, 58, 50, 42, 38, 29, 17,  4,
+		62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12,  5,
+		63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11,
+		46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19,  9, 13,  8,  7,  6
+	};
+	return index[((b & (0 - b)) * 0x03f79d71b4cb0a89ULL) >> 58];
+#endif
+}
+
+/**
+ * Returns the number of set bits.
+ * @param b - The bit field to count.
+ */
+inline int popCount(unsigned long long b)
+{
+#if defined(__GNUC__)
+	return __builtin_popcountll(b);
+#else
+	int count = 0;
+	for(; b; b &= b - 1)
+		count++;
+	return count;
+#endif
+}
+
 #endif
  
 // End of file bitboard.h
@@ -15,6 +15,15 @@ using std::cout;
 using std::endl;
 using std::vector;
 
+// xorshift64* generator for the Zobrist keys
+static unsigned long long random64(unsigned long long & state)
+{
+	state ^= state >> 12;
+	state ^= state << 25;
+	state ^= state >> 27;
+	return state * 2685821657736338717LL;
+}
+
 unsigned long long Board::pawnAttacks[2][64];
 unsigned long long Board::knightAttacks[64];
 unsigned long long Board::kingAttacks[64];
@@ -26,6 +35,68 @@ unsigned long long Board::diagAttacksNE[64][256];
 Piece* Board::m_allpieces[Piece::LAST_COLOR + 1][Piece::LAST_TYPE + 1];
 bool Board::m_setup = false;
 
+unsigned long long Board::m_zobrist_pieces[Piece::LAST_COLOR + 1][Piece::LAST_TYPE + 1][64];
+unsigned long long Board::m_zobrist_castling[16];
+unsigned long long Board::m_zobrist_enpassant[2][256];
+unsigned long long Board::m_zobrist_white;
+
+int Board::pieceValue[Piece::LAST_TYPE + 1] = {100, 500, 310, 325, 900, 0};
+int Board::phaseWeight[Piece::LAST_TYPE + 1] = {0, 2, 1, 1, 4, 0};
+int Board::pieceSquare[2][Piece::LAST_COLOR + 1][Piece::LAST_TYPE + 1][64];
+
+// Positional bonuses from white's side of the board, a1 first. Black's
+// are the same tables turned over.
+static const int pawnTable[64] = {
+    0,0,0,0,0,0,0,0,
+    0,0,0,-5,-5,0,0,0,
+    1,2,3,4,4,3,2,1,
+    2,4,6,8,8,6,4,2,
+    3,6,9,12,12,9,6,3,
+    4,8,12,16,16,12,8,4,
+    5,10,15,20,20,15,10,5,
+    0,0,0,0,0,0,0,0 };
+
+static const int knightTable[64] = {
+    -10,-5,-5,-5,-5,-5,-5,-10,
+    -5,0,0,3,3,0,0,-5,
+    -5,0,5,5,5,5,0,-5,
+    -5,0,5,10,10,5,0,-5,
+    -5,0,5,10,10,5,0,-5,
+    -5,0,5,5,5,5,0,-5,
+    -5,0,0,3,3,0,0,-5,
+    -10,-5,-5,-5,-5,-5,-5,-10 };
+
+static const int bishopTable[64] = {
+    -5,-5,-5,-5,-5,-5,-5,-5,
+    -5,10,5,10,10,5,10,-5,
+    -5,5,3,12,12,3,5,-5,
+    -5,3,12,3,3,12,3,-5,
+    -5,3,12,3,3,12,3,-5,
+    -5,5,3,12,12,3,5,-5,
+    -5,10,5,10,10,5,10,-5,
+    -5,-5,-5,-5,-5,-5,-5,-5 };
+
+// Kings stay behind their pawns until the endgame, then head for the middle
+static const int kingTable[64] = {
+    2,10,4,0,0,7,10,2,
+    -3,-3,-5,-5,-5,-5,-3,-3,
+    -5,-5,-8,-8,-8,-8,-5,-5,
+    -8,-8,-13,-13,-13,-13,-8,-8,
+    -13,-13,-21,-21,-21,-21,-13,-13,
+    -21,-21,-34,-34,-34,-34,-21,-21,
+    -34,-34,-55,-55,-55,-55,-34,-34,
+    -55,-55,-89,-89,-89,-89,-55,-55};
+
+static const int endKingTable[64] = {
+    -5,-3,-1,0,0,-1,-3,-5,
+    -3,5,5,5,5,5,5,-3,
+    -1,5,10,10,10,10,5,-1,
+    0,5,10,15,15,10,5,0,
+    0,5,10,15,15,10,5,0,
+    -1,5,10,10,10,10,5,-1,
+    -3,5,5,5,5,5,5,-3,
+    -5,-3,-1,0,0,-1,-3,-5};
+
 Board::Board()
 {
 	reset();
@@ -55,6 +126,15 @@ void Board::reset()
 	m_enpassant_flags = 0LL;
 	m_total_pieces[Piece::WHITE] = 0;
 	m_total_pieces[Piece::BLACK] = 0;
+	m_hash = 0LL;
+	m_pawn_hash = 0LL;
+
+	for (int i=0; i <= Piece::LAST_COLOR; i++) {
+		m_material[i] = 0;
+		m_score[MIDDLEGAME][i] = 0;
+		m_score[ENDGAME][i] = 0;
+	}
+	m_phase = 0;
 }
 
 void Board::setupPieces()
@@ -103,6 +183,11 @@ void Board::setPiece(Piece::Color c, Piece::Type t, const BoardPosition& bp)
 
 	setBit(m_pieces[t], bp);
 	setBit(m_color[c], bp);
+	m_hash ^= m_zobrist_pieces[c][t][bp.hash()];
+	if(t == Piece::PAWN) {
+		m_pawn_hash ^= m_zobrist_pieces[c][t][bp.hash()];
+	}
+	addScore(c, t, bp.hash(), 1);
 
 	if(t == Piece::KING) {
 		m_king_pos[c] = bp;
@@ -122,6 +207,11 @@ void Board::setPiece(Piece * piece, const BoardPosition & bp)
     
 	setBit(m_pieces[piece->m_type], bp);
 	setBit(m_color[piece->m_color], bp);
+	m_hash ^= m_zobrist_pieces[piece->m_color][piece->m_type][bp.hash()];
+	if(piece->m_type == Piece::PAWN) {
+		m_pawn_hash ^= m_zobrist_pieces[piece->m_color][piece->m_type][bp.hash()];
+	}
+	addScore(piece->m_color, piece->m_type, bp.hash(), 1);
 
 	if(piece->m_type == Piece::KING) {
 		m_king_pos[piece->m_color] = bp;
@@ -221,47 +311,8 @@ bool Board::isMoveLegal(const BoardMove & bm) const
 	}
 
 	// Check for all the castling stuff
-	if(type == Piece::KING && bm.fileDiff() == 2)
-	{
-		// Check if the king has moved
-		if(!(getMask(bm.origin()) & m_castling_flags)) {
-			return false;
-		}
-		
-		// Check if the king is in check, or if castling places him in check.
-        if(this->isAttacked(bm.origin(), color) || this->isAttacked(bm.dest(), color)) {
-			return false;
-		}
-
-		char oldRookFile;
-		if(bm.signedFileDiff() == -2) {
-			oldRookFile = 'a';
-		} else {
-			oldRookFile = 'h';
-		}
-
-		// Check if the rook has moved
-		BoardPosition corner = BoardPosition(oldRookFile, bm.origin().rank());
-		if(!(getMask(corner) & m_castling_flags)) {
-			return false;
-		}
-
-        // There must be no pieces between the king and rook.
-        BoardPosition pos;
-        bool castleEast = (bm.signedFileDiff() > 0);
-        for (pos = castleEast ? bm.origin().E() : bm.origin().W(); pos != corner; pos = (castleEast) ? pos.E() : pos.W()) {
-            if (this->getPiece(pos)) {
-                return false;
-            }
-        }
-
-        // The king can not pass through squares that are under attack by enemy pieces.
-        if (castleEast && (this->isAttacked(bm.origin().E(), color))) {
-            return false;            
-        }
-        else if (!castleEast && this->isAttacked(bm.origin().W(), color)) {
-            return false;
-        }
+	if(type == Piece::KING && bm.fileDiff() == 2 && !isCastlingLegal(bm)) {
+		return false;
 	}
 
     /**********************DEBUG CODE*******************************/
@@ -299,6 +350,53 @@ bool Board::isMoveLegal(const BoardMove & bm) const
 	return true;
 }
 
+bool Board::isCastlingLegal(const BoardMove & bm) const
+{
+	Piece::Color color = getPiece(bm.origin())->color();
+
+	// Check if the king has moved
+	if(!(getMask(bm.origin()) & m_castling_flags)) {
+		return false;
+	}
+
+	// Check if the king is in check, or if castling places him in check.
+	if(this->isAttacked(bm.origin(), color) || this->isAttacked(bm.dest(), color)) {
+		return false;
+	}
+
+	char oldRookFile;
+	if(bm.signedFileDiff() == -2) {
+		oldRookFile = 'a';
+	} else {
+		oldRookFile = 'h';
+	}
+
+	// Check if the rook has moved
+	BoardPosition corner = BoardPosition(oldRookFile, bm.origin().rank());
+	if(!(getMask(corner) & m_castling_flags)) {
+		return false;
+	}
+
+	// There must be no pieces between the king and rook.
+	BoardPosition pos;
+	bool castleEast = (bm.signedFileDiff() > 0);
+	for (pos = castleEast ? bm.origin().E() : bm.origin().W(); pos != corner; pos = (castleEast) ? pos.E() : pos.W()) {
+		if (this->getPiece(pos)) {
+			return false;
+		}
+	}
+
+	// The king can not pass through squares that are under attack by enemy pieces.
+	if (castleEast && (this->isAttacked(bm.origin().E(), color))) {
+		return false;
+	}
+	else if (!castleEast && this->isAttacked(bm.origin().W(), color)) {
+		return false;
+	}
+
+	return true;
+}
+
 unsigned long long Board::isAttacked(const BoardPosition& bp, Piece::Color c) const
 {
 	Piece::Color attacker = Piece::opposite(c);
@@ -376,142 +474,121 @@ bool Board::isMaterialDraw() const
 
 vector<BoardMove> Board::possibleMoves(Piece::Color c, bool findOne) const
 {
-	vector<BoardPosition> pos;
-	vector<BoardMove> goodMoves, trialMoves;
-	
-	// Find all of this players pieces
-	for(int i=0; i < BOARDSIZE*BOARDSIZE; i++) {
-		if((m_color[c] >> i) & 1)
-			pos.push_back(BoardPosition(i));
+	BoardMove trialMoves[MAX_MOVES];
+	vector<BoardMove> goodMoves;
+	int count = generateMoves(c, trialMoves);
+
+	// Keep the moves that don't leave the king in check
+	Board board;
+	for(int i=0; i < count; i++) {
+		board = *this;
+		board.update(trialMoves[i]);
+		if(board.isCheck(c)) {
+			continue;
+		}
+		goodMoves.push_back(trialMoves[i]);
+		if(findOne) {
+			return goodMoves;
+		}
 	}
 
-	// Find all possible move for each piece
-	for(int i=0; i < pos.size(); i++) {
-		Piece* p = getPiece(pos[i]);
-		BoardPosition bp;
+	return goodMoves;
+}
 
-        // This is here since C++ is gay
-        int last;
-		
-        // Generate possible moves for pieces performing a few simple tests
-		// to make sure that they are valid
-		switch(p->type()) {
-			case Piece::PAWN:
-				if(c == Piece::WHITE) {
-					trialMoves.push_back(BoardMove(pos[i], pos[i].N().N(), p));
-					trialMoves.push_back(BoardMove(pos[i], pos[i].N(), p));
-					trialMoves.push_back(BoardMove(pos[i], pos[i].NE(), p));
-					trialMoves.push_back(BoardMove(pos[i], pos[i].NW(), p));
-				} else {
-				    trialMoves.push_back(BoardMove(pos[i], pos[i].S().S(), p));
-					trialMoves.push_back(BoardMove(pos[i], pos[i].S(), p));
-					trialMoves.push_back(BoardMove(pos[i], pos[i].SE(), p));
-					trialMoves.push_back(BoardMove(pos[i], pos[i].SW(), p));
-				}
+int Board::generateMoves(Piece::Color c, BoardMove * moves, bool tactical) const
+{
+	int count = 0;
+	Piece::Color them = Piece::opposite(c);
+	unsigned long long occupied = m_color[Piece::WHITE] | m_color[Piece::BLACK];
+	unsigned long long targets = tactical ? m_color[them] : ~m_color[c];
+
+	// Pawns move one way, capture another, and promote
+	Piece * pawn = m_allpieces[c][Piece::PAWN];
+	int forward = (c == Piece::WHITE) ? BOARDSIZE : -BOARDSIZE;
+	int startRank = (c == Piece::WHITE) ? 1 : 6;
+	int lastRank = (c == Piece::WHITE) ? 7 : 0;
+	unsigned long long enpassant = m_enpassant_flags &
+		((c == Piece::WHITE) ? maskRank(BoardPosition('a', 6)) : maskRank(BoardPosition('a', 3)));
+
+	for(unsigned long long pawns = m_pieces[Piece::PAWN] & m_color[c]; pawns; pawns &= pawns - 1) {
+		int from = bitScanForward(pawns);
+		BoardPosition origin(from);
+		unsigned long long dests = pawnAttacks[c][from] & (m_color[them] | enpassant);
+
+		int to = from + forward;
+		if(!(occupied & (1LL << to))) {
+			dests |= 1LL << to;
+			int to2 = to + forward;
+			if(!tactical && origin.rank0() == startRank && !(occupied & (1LL << to2))) {
+				dests |= 1LL << to2;
+			}
+		}
 
-				// Needed outside the loop since size of trialMoves changes
-				last = trialMoves.size()-1;
-				for(int j=0; j < 3; j++) {
-					if(trialMoves[last-j].needPromotion()) {
-						BoardMove move = trialMoves[last-j];
-						trialMoves[last-j].setPromotion(Piece::QUEEN);
-						move.setPromotion(Piece::ROOK);
-						trialMoves.push_back(move);
-						move.setPromotion(Piece::BISHOP);
-						trialMoves.push_back(move);
-						move.setPromotion(Piece::KNIGHT);
-						trialMoves.push_back(move);
-					}
+		for(; dests; dests &= dests - 1) {
+			BoardPosition dest(bitScanForward(dests));
+			bool capture = (dest.file0() != origin.file0());
+			if(dest.rank0() == lastRank) {
+				moves[count++] = BoardMove(origin, dest, pawn, Piece::QUEEN);
+				if(capture || !tactical) {
+					moves[count++] = BoardMove(origin, dest, pawn, Piece::ROOK);
+					moves[count++] = BoardMove(origin, dest, pawn, Piece::BISHOP);
+					moves[count++] = BoardMove(origin, dest, pawn, Piece::KNIGHT);
 				}
-				break;
-			case Piece::KNIGHT:
-				trialMoves.push_back(BoardMove(pos[i], pos[i].NE().N(), p));
-				trialMoves.push_back(BoardMove(pos[i], pos[i].NE().E(), p));
-				trialMoves.push_back(BoardMove(pos[i], pos[i].NW().N(), p));
-				trialMoves.push_back(BoardMove(pos[i], pos[i].NW().W(), p));
-				trialMoves.push_back(BoardMove(pos[i], pos[i].SE().S(), p));
-				trialMoves.push_back(BoardMove(pos[i], pos[i].SE().E(), p));
-				trialMoves.push_back(BoardMove(pos[i], pos[i].SW().S(), p));
-				trialMoves.push_back(BoardMove(pos[i], pos[i].SW().W(), p));
-				break;
-			case Piece::QUEEN:
-			case Piece::BISHOP:
-				for(bp = pos[i].NE(); !bp.outNE(); bp.moveNE()) {
-					trialMoves.push_back(BoardMove(pos[i], bp, p));
-					if(isOccupied(bp))
-						break;
-				} 
-				for(bp = pos[i].NW(); !bp.outNW(); bp.moveNW()) {
-					trialMoves.push_back(BoardMove(pos[i], bp, p));
-					if(isOccupied(bp))
-						break;
-				} 
-
-				for(bp = pos[i].SW(); !bp.outSW(); bp.moveSW()) {
-					trialMoves.push_back(BoardMove(pos[i], bp, p));
-					if(isOccupied(bp))
-						break;
-				} 
+			} else if(capture || !tactical) {
+				moves[count++] = BoardMove(origin, dest, pawn);
+			}
+		}
+	}
 
-				for(bp = pos[i].SE(); !bp.outSE(); bp.moveSE()) {
-					trialMoves.push_back(BoardMove(pos[i], bp, p));
-					if(isOccupied(bp))
-						break;
-				}
-				if(p->type() == Piece::BISHOP)
+	// Everything else moves the same way it attacks
+	for(int t = Piece::ROOK; t <= Piece::KING; t++) {
+		Piece * piece = m_allpieces[c][t];
+		for(unsigned long long pieces = m_pieces[t] & m_color[c]; pieces; pieces &= pieces - 1) {
+			int from = bitScanForward(pieces);
+			BoardPosition origin(from);
+			unsigned long long dests = 0LL;
+
+			switch(t) {
+				case Piece::KNIGHT:
+					dests = knightAttacks[from];
 					break;
-			case Piece::ROOK:
-				for(bp = pos[i].N(); !bp.outN(); bp.moveN()) {
-					trialMoves.push_back(BoardMove(pos[i], bp, p));
-					if(isOccupied(bp))
-						break;
-				} 
-
-				for(bp = pos[i].W(); !bp.outW(); bp.moveW()) {
-					trialMoves.push_back(BoardMove(pos[i], bp, p));
-					if(isOccupied(bp))
-						break;
-				} 
-
-				for(bp = pos[i].S(); !bp.outS(); bp.moveS()) {
-					trialMoves.push_back(BoardMove(pos[i], bp, p));
-					if(isOccupied(bp))
+				case Piece::KING:
+					dests = kingAttacks[from];
+					break;
+				case Piece::QUEEN:
+				case Piece::BISHOP:
+					dests |= diagAttacksSE[from][getSEDiagState(origin)];
+					dests |= diagAttacksNE[from][getNEDiagState(origin)];
+					if(t == Piece::BISHOP)
 						break;
-				} 
+					// fall through - a queen also moves like a rook
+				case Piece::ROOK:
+					dests |= rankAttacks[from][getRankState(origin)];
+					dests |= fileAttacks[from][getFileState(origin)];
+					break;
+			}
 
-				for(bp = pos[i].E(); !bp.outE(); bp.moveE()) {
-					trialMoves.push_back(BoardMove(pos[i], bp, p));
-					if(isOccupied(bp))
-						break;
-				}
-				break;
-			case Piece::KING:
-				trialMoves.push_back(BoardMove(pos[i], pos[i].N(), p));
-				trialMoves.push_back(BoardMove(pos[i], pos[i].S(), p));
-				trialMoves.push_back(BoardMove(pos[i], pos[i].E(), p));
-				trialMoves.push_back(BoardMove(pos[i], pos[i].W(), p));
-				trialMoves.push_back(BoardMove(pos[i], pos[i].NE(), p));
-				trialMoves.push_back(BoardMove(pos[i], pos[i].NW(), p));
-				trialMoves.push_back(BoardMove(pos[i], pos[i].SE(), p));
-				trialMoves.push_back(BoardMove(pos[i], pos[i].SW(), p));
-				trialMoves.push_back(BoardMove(pos[i], pos[i].E().E(), p));
-				trialMoves.push_back(BoardMove(pos[i], pos[i].W().W(), p));
-				break;
+			for(dests &= targets; dests; dests &= dests - 1) {
+				moves[count++] = BoardMove(origin, BoardPosition(bitScanForward(dests)), piece);
+			}
 		}
+	}
 
-		// For the moves that passed the basic test
-		for(int j=0; j < trialMoves.size(); j++) {
-			if(isMoveLegal(trialMoves[j])) {
-				goodMoves.push_back(trialMoves[j]);
-			}
-			if(goodMoves.size() && findOne) {
-				return goodMoves;
-			}
+	// Castling, only worth a look while the king still has its flag
+	BoardPosition king = m_king_pos[c];
+	if(!tactical && (getMask(king) & m_castling_flags) && king.file0() == 4) {
+		Piece * piece = m_allpieces[c][Piece::KING];
+		BoardMove east(king, king.E().E(), piece);
+		BoardMove west(king, king.W().W(), piece);
+		if(isCastlingLegal(east)) {
+			moves[count++] = east;
+		}
+		if(isCastlingLegal(west)) {
+			moves[count++] = west;
 		}
-		trialMoves.clear();
 	}
-	
-	return goodMoves;
+
+	return count;
 }
 
 int Board::getRankState(const BoardPosition & bp) const
@@ -582,10 +659,16 @@ void Board::update(const BoardMove & bm)
 	if(type == Piece::PAWN) {
 		if(isEnPassantSet(bm.dest()) && color == Piece::WHITE) {
 			removePiece(bm.dest().S());
+			m_piece_count[Piece::BLACK][Piece::PAWN]--;
+			m_total_pieces[Piece::BLACK]--;
 		} else if(isEnPassantSet(bm.dest()) && color == Piece::BLACK) {
 			removePiece(bm.dest().N());
+			m_piece_count[Piece::WHITE][Piece::PAWN]--;
+			m_total_pieces[Piece::WHITE]--;
 		} else if(bm.dest().rank() == 8 || bm.dest().rank() == 1) {
 			type = bm.getPromotion();
+			m_piece_count[color][Piece::PAWN]--;
+			m_piece_count[color][type]++;
 		}
 	} else if(type == Piece::KING && bm.signedFileDiff() == -2) {
 		// Castling to the left
@@ -612,6 +695,16 @@ void Board::update(const BoardMove & bm)
 	setSpecialPieceFlags(bm);
 }
 
+void Board::makeNullMove(Piece::Color c)
+{
+	// Same en passant bookkeeping as setSpecialPieceFlags
+	if (c == Piece::BLACK) {
+		m_enpassant_flags &= ~maskRank(BoardPosition('a', 3));
+	} else {
+		m_enpassant_flags &= ~maskRank(BoardPosition('a', 6));
+	}
+}
+
 void Board::setSpecialPieceFlags(const BoardMove & bm)
 {
 	Piece::Color color = bm.getPiece()->color();
@@ -675,19 +768,109 @@ SerialBoard Board::serialize() const
 	return sb;
 }
 
+unsigned long long Board::hashKey(Piece::Color c) const
+{
+	// A side can castle while both its king and the rook are unmoved
+	unsigned long long f = m_castling_flags;
+	int castling = ((f >> 4) & (f >> 7) & 1) |
+	               (((f >> 4) & f & 1) << 1) |
+	               (((f >> 60) & (f >> 63) & 1) << 2) |
+	               (((f >> 60) & (f >> 56) & 1) << 3);
+
+	unsigned long long key = m_hash ^ m_zobrist_castling[castling];
+	key ^= m_zobrist_enpassant[0][(m_enpassant_flags >> 2*BOARDSIZE) & 0xFF];
+	key ^= m_zobrist_enpassant[1][(m_enpassant_flags >> 5*BOARDSIZE) & 0xFF];
+
+	return (c == Piece::WHITE) ? key ^ m_zobrist_white : key;
+}
+
+void Board::setCastlingRights(bool wk, bool wq, bool bk, bool bq)
+{
+	m_castling_flags = 0LL;
+
+	unsigned long long wkings = m_pieces[Piece::KING] & m_color[Piece::WHITE];
+	unsigned long long bkings = m_pieces[Piece::KING] & m_color[Piece::BLACK];
+	unsigned long long wrooks = m_pieces[Piece::ROOK] & m_color[Piece::WHITE];
+	unsigned long long brooks = m_pieces[Piece::ROOK] & m_color[Piece::BLACK];
+
+	if(!(wkings & getMask(BoardPosition('e', 1))))
+		wk = wq = false;
+	if(!(wrooks & getMask(BoardPosition('h', 1))))
+		wk = false;
+	if(!(wrooks & getMask(BoardPosition('a', 1))))
+		wq = false;
+	if(!(bkings & getMask(BoardPosition('e', 8))))
+		bk = bq = false;
+	if(!(brooks & getMask(BoardPosition('h', 8))))
+		bk = false;
+	if(!(brooks & getMask(BoardPosition('a', 8))))
+		bq = false;
+
+	if(wk || wq)
+		m_castling_flags |= getMask(BoardPosition('e', 1));
+	if(wk)
+		m_castling_flags |= getMask(BoardPosition('h', 1));
+	if(wq)
+		m_castling_flags |= getMask(BoardPosition('a', 1));
+
+	if(bk || bq)
+		m_castling_flags |= getMask(BoardPosition('e', 8));
+	if(bk)
+		m_castling_flags |= getMask(BoardPosition('h', 8));
+	if(bq)
+		m_castling_flags |= getMask(BoardPosition('a', 8));
+}
+
+bool Board::canCastle(Piece::Color c, bool kingside) const
+{
+	int rank = (c == Piece::WHITE) ? 1 : 8;
+	return (m_castling_flags & getMask(BoardPosition('e', rank))) &&
+	       (m_castling_flags & getMask(BoardPosition(kingside ? 'h' : 'a', rank)));
+}
+
+bool Board::canCaptureEnPassant(Piece::Color c) const
+{
+	unsigned long long enpassant = m_enpassant_flags &
+		((c == Piece::WHITE) ? maskRank(BoardPosition('a', 6)) : maskRank(BoardPosition('a', 3)));
+	for(unsigned long long pawns = m_pieces[Piece::PAWN] & m_color[c]; pawns && enpassant; pawns &= pawns - 1) {
+		if(pawnAttacks[c][bitScanForward(pawns)] & enpassant) {
+			return true;
+		}
+	}
+	return false;
+}
+
 // Unsets all of the pieces bits, and the occupied bit for 'bp'
 inline void Board::unsetAllBits(const BoardPosition & bp)
 {
-	unsigned long long mask = ~getMask(bp);
-
-	// Unset all the piece bits
-	for(int i = 0; i <= Piece::LAST_TYPE; i++)
+	unsigned long long bit = getMask(bp);
+	unsigned long long mask = ~bit;
+	int color = (m_color[Piece::WHITE] & bit) ? Piece::WHITE : Piece::BLACK;
+
+	// Unset all the piece bits, taking the piece out of the hash key and
+	// the running scores
+	for(int i = 0; i <= Piece::LAST_TYPE; i++) {
+		if(m_pieces[i] & bit) {
+			m_hash ^= m_zobrist_pieces[color][i][bp.hash()];
+			if(i == Piece::PAWN)
+				m_pawn_hash ^= m_zobrist_pieces[color][i][bp.hash()];
+			addScore(Piece::Color(color), Piece::Type(i), bp.hash(), -1);
+		}
 		m_pieces[i] &= mask;
+	}
 
 	for (int i = 0; i <= Piece::LAST_COLOR; i++)
 		m_color[i] &= mask;
 }
 
+inline void Board::addScore(Piece::Color c, Piece::Type t, int sq, int sign)
+{
+	m_material[c] += sign*pieceValue[t];
+	m_score[MIDDLEGAME][c] += sign*pieceSquare[MIDDLEGAME][c][t][sq];
+	m_score[ENDGAME][c] += sign*pieceSquare[ENDGAME][c][t][sq];
+	m_phase += sign*phaseWeight[t];
+}
+
 std::ostream& operator<< (std::ostream& os, const Board& b)
 {
 	for (int rank = 8; rank > 0; rank--) {
@@ -707,6 +890,50 @@ void Board::init()
 	pow2[0] = 1;
 	for(int i = 1; i < BOARDSIZE; i++)
 		pow2[i] = 2*pow2[i-1];
+
+	// Zobrist keys come from a fixed seed so that keys, and therefore
+	// searches, are the same from run to run.
+	unsigned long long seed = 0x9E3779B97F4A7C15LL;
+	for(int c = 0; c <= Piece::LAST_COLOR; c++)
+		for(int t = 0; t <= Piece::LAST_TYPE; t++)
+			for(int i = 0; i < BOARDSIZE*BOARDSIZE; i++)
+				m_zobrist_pieces[c][t][i] = random64(seed);
+
+	m_zobrist_castling[0] = 0LL;
+	for(int i = 1; i < 16; i++)
+		m_zobrist_castling[i] = random64(seed);
+
+	// Each en passant file gets a key, a rank state hashes to the xor of
+	// the keys of its set bits.
+	for(int side = 0; side < 2; side++) {
+		unsigned long long file[BOARDSIZE];
+		for(int i = 0; i < BOARDSIZE; i++)
+			file[i] = random64(seed);
+		for(int state = 0; state < 256; state++) {
+			m_zobrist_enpassant[side][state] = 0LL;
+			for(int i = 0; i < BOARDSIZE; i++)
+				if(state & (1 << i))
+					m_zobrist_enpassant[side][state] ^= file[i];
+		}
+	}
+
+	m_zobrist_white = random64(seed);
+
+	// Piece values with their positional bonuses, seen from each side
+	for(int phase = MIDDLEGAME; phase <= ENDGAME; phase++) {
+		for(int c = 0; c <= Piece::LAST_COLOR; c++) {
+			for(int i = 0; i < BOARDSIZE*BOARDSIZE; i++) {
+				int sq = (c == Piece::WHITE) ? i : i ^ 56;
+				int (*psq)[64] = pieceSquare[phase][c];
+				for(int t = 0; t <= Piece::LAST_TYPE; t++)
+					psq[t][i] = pieceValue[t];
+				psq[Piece::PAWN][i] += pawnTable[sq];
+				psq[Piece::KNIGHT][i] += knightTable[sq];
+				psq[Piece::BISHOP][i] += bishopTable[sq];
+				psq[Piece::KING][i] += (phase == ENDGAME) ? endKingTable[sq] : kingTable[sq];
+			}
+		}
+	}
 	
 	// Initialize attack masks for non-sliding pieces
 	for(int i = 0; i < BOARDSIZE*BOARDSIZE; i++) {
@@ -73,6 +73,13 @@ class Board {
 	BitBoard getPieces(Piece::Color c, Piece::Type t) const
 		{return BitBoard(m_pieces[t] & m_color[c]);}
 
+	/**
+	 * Returns the bit board with the positions of all the pieces of color c
+	 * @param c - The color of pieces to return
+	 */
+	BitBoard getPieces(Piece::Color c) const
+		{ return BitBoard(m_color[c]); }
+
 	/**
 	 * Sets the internal bitboard at BoardPosition bp to indicate a piece of
 	 * type t and color c
@@ -165,6 +172,15 @@ class Board {
 
 	bool isMaterialDraw() const;
 
+	/**
+	 * Returns true if the player has any pieces other than pawns and the
+	 * king. Used to guard null move pruning against zugzwang.
+	 * @param c - The color to check
+	 */
+	bool hasNonPawnMaterial(Piece::Color c) const
+		{ return (m_piece_count[c][Piece::KNIGHT] + m_piece_count[c][Piece::BISHOP] +
+		          m_piece_count[c][Piece::ROOK] + m_piece_count[c][Piece::QUEEN]) > 0; }
+
 	/**
 	 * Returns true if a Pawn can move to the specified BoardPosition to
 	 * perform an en-passant move.
@@ -173,8 +189,25 @@ class Board {
 	bool isEnPassantSet(const BoardPosition & bp) const
 		{ return (0 != (getMask(bp) & m_enpassant_flags)); }
 
+	/**
+	 * Returns true if color c has a pawn that can capture en passant right
+	 * now, ignoring whether the capture would leave its king in check.
+	 */
+	bool canCaptureEnPassant(Piece::Color c) const;
+
 	vector<BoardMove> possibleMoves(Piece::Color color, bool findOne=false) const;
 
+	/**
+	 * Writes the pseudo-legal moves for color into moves, returning how
+	 * many there are. The moves obey every rule except that they may leave
+	 * the player's own king in check, the caller has to test for that after
+	 * making the move. Never allocates, so it is safe for the search.
+	 * @param color - The color to generate moves for.
+	 * @param moves - Room for at least MAX_MOVES moves.
+	 * @param tactical - Only generate captures and queen promotions.
+	 */
+	int generateMoves(Piece::Color color, BoardMove * moves, bool tactical=false) const;
+
 	/** */
 	BoardPosition getKing(Piece::Color c) const
 		{ return m_king_pos[c]; }
@@ -205,17 +238,84 @@ class Board {
 	 */
 	void update(const BoardMove & bm);
 
+	/**
+	 * Passes the turn without moving a piece, clearing the en passant flags
+	 * the player's move would have cleared. Only used by the search.
+	 * @param c - The color of the player passing.
+	 */
+	void makeNullMove(Piece::Color c);
+
 	/** */
 	void addPiece(Piece * p, const BoardPosition & bp);
 
 	/** */
 	SerialBoard serialize() const;
+
+	/**
+	 * Returns the Zobrist key for this position with color c to move. Equal
+	 * positions always have equal keys, so it can index hash tables.
+	 * @param c - The color to move.
+	 */
+	unsigned long long hashKey(Piece::Color c) const;
+
+	/**
+	 * Returns the Zobrist key of the pawns alone, for caching anything that
+	 * depends only on the pawn structure.
+	 */
+	unsigned long long pawnKey() const
+		{ return m_pawn_hash; }
+
+	/** The two halves of the game the piece-square tables differ for */
+	enum Phase { MIDDLEGAME = 0, ENDGAME = 1 };
+
+	/**
+	 * Returns how much of the middlegame is left, from MAX_PHASE with all
+	 * the pieces on the board down to 0 with only kings and pawns. Scores
+	 * are blended between the two phases by it.
+	 */
+	int phase() const
+		{ return (m_phase < MAX_PHASE) ? m_phase : MAX_PHASE; }
+
+	/** Returns the material of color c, kings not counted. */
+	int material(Piece::Color c) const
+		{ return m_material[c]; }
+
+	/**
+	 * Returns the material of color c plus the piece-square bonuses of its
+	 * pieces in the given phase. Both are kept up to date as pieces are
+	 * set and removed, so evaluating them costs nothing.
+	 */
+	int score(Piece::Color c, Phase phase) const
+		{ return m_score[phase][c]; }
+
+	/**
+	 * Sets the castling rights, for boards that aren't set up by playing
+	 * moves from the starting position.  A right is dropped when its king
+	 * or rook isn't on its home square.
+	 */
+	void setCastlingRights(bool wk, bool wq, bool bk, bool bq);
+
+	/**
+	 * Returns true if color c still has the right to castle on the given
+	 * side, whether or not it could castle right now.
+	 */
+	bool canCastle(Piece::Color c, bool kingside) const;
+
+	/**
+	 * Marks bp as the square a pawn skipped over with a double step, so it
+	 * can be captured en passant.
+	 */
+	void setEnPassant(const BoardPosition & bp)
+		{ m_enpassant_flags |= getMask(bp); }
 	
 	/**
 	 * This is just the size of the board, useful for looping over a board.
 	 */
 	const static int BOARDSIZE = 8;
 
+	/** More than the number of moves possible in any position. */
+	const static int MAX_MOVES = 256;
+
 	static unsigned long long pawnAttacks[2][64];
 	static unsigned long long knightAttacks[64];
 	static unsigned long long kingAttacks[64];
@@ -224,12 +324,50 @@ class Board {
 	static unsigned long long diagAttacksSE[64][256];
 	static unsigned long long diagAttacksNE[64][256];
 
+	/** Value of each piece type, kings are worth nothing as material */
+	static int pieceValue[Piece::LAST_TYPE + 1];
+
+	/** How much each piece type counts towards the phase, pawns and kings not at all */
+	static int phaseWeight[Piece::LAST_TYPE + 1];
+
+	/** Phase with every piece of the starting position still on the board */
+	const static int MAX_PHASE = 24;
+
+	/**
+	 * Value plus positional bonus of a piece on each square in each phase,
+	 * filled in by init()
+	 */
+	static int pieceSquare[2][Piece::LAST_COLOR + 1][Piece::LAST_TYPE + 1][64];
+
 	friend class BrutalPlayer;
+	friend class Network;
 
  private:
 	static Piece* m_allpieces[Piece::LAST_COLOR + 1][Piece::LAST_TYPE + 1];
 	static bool m_setup;
 
+	// Random keys for Zobrist hashing, filled in by init()
+	static unsigned long long m_zobrist_pieces[Piece::LAST_COLOR + 1][Piece::LAST_TYPE + 1][64];
+	static unsigned long long m_zobrist_castling[16];
+	static unsigned long long m_zobrist_enpassant[2][256];
+	static unsigned long long m_zobrist_white;
+
+	// Zobrist key of the pieces only, castling, en passant and the turn
+	// are folded in by hashKey()
+	unsigned long long m_hash;
+
+	// Zobrist key of the pawns only
+	unsigned long long m_pawn_hash;
+
+	// Running sums of pieceValue, pieceSquare and phaseWeight over the pieces
+	// on the board
+	int m_material[Piece::LAST_COLOR + 1];
+	int m_score[2][Piece::LAST_COLOR + 1];
+	int m_phase;
+
+	/** Adds or takes away a piece from the running sums. */
+	inline void addScore(Piece::Color c, Piece::Type t, int sq, int sign);
+
 	int m_total_pieces[Piece::LAST_COLOR + 1];
 	int m_piece_count[Piece::LAST_COLOR + 1][Piece::LAST_TYPE + 1];
 
@@ -243,6 +381,13 @@ class Board {
 	BoardPosition m_king_pos[Piece::LAST_COLOR + 1];
 
 	inline void unsetAllBits(const BoardPosition & bp);
+
+	/**
+	 * Checks the castling specific rules for a king move of two files, the
+	 * king and rook must not have moved and the king may not castle out of,
+	 * through, or into check.
+	 */
+	bool isCastlingLegal(const BoardMove & bm) const;
 };
 
 static int pow2[8];
@@ -32,7 +32,7 @@ BoardMove::LegalMapInitializer::LegalMapInitializer()
 // Returns true if this move put a pawn into a promotable boardposition.
 bool BoardMove::needPromotion() const
 {
-	if (m_moved->type() != Piece::PAWN) {
+	if (!m_moved || m_moved->type() != Piece::PAWN) {
 		return false;
 	}
 	if (m_dest.rank() != 1 && m_dest.rank() != 8) {
@@ -23,8 +23,8 @@ class BoardMove {
 
  public:
 
-	/** Default constructor, doesn't do anything. */
-	BoardMove() {}
+	/** Default constructor, creates an invalid move. */
+	BoardMove() : m_moved(0), m_promote(Piece::NOTYPE) {}
 
 	/** Constructs a board move that goes from 'origin' to 'dest'. */
 	BoardMove(const BoardPosition& origin, const BoardPosition& dest, Piece* moved, 
@@ -15,6 +15,7 @@
 #include <cmath>
 
 // Helper declarations
+static void drawArrow(const BoardMove & bm);
 static void drawArrowShaft(const BoardMove & bm);
 static void drawArrowHead(const BoardMove & bm, const float & angle = -1.0);
 static void drawAngleIron(const BoardMove & bm);
@@ -26,6 +27,14 @@ static float getAngleFromMove(const BoardMove & bm);
 
 void BoardTheme::drawMoveArrows(const ChessGameState & cgs)
 {
+	glNormal3d(0.0, 7.0, 0.0);
+
+	// The hint is green so it can't be mistaken for a move already made
+	if (m_hint.isValid()) {
+		glColor4d(0.2, 1.0, 0.2, 0.6);
+		drawArrow(m_hint);
+	}
+
     if (!Options::getInstance()->historyarrows)
         return;
 
@@ -35,21 +44,26 @@ void BoardTheme::drawMoveArrows(const ChessGameState & cgs)
 	if (!move.origin().isValid())
 		return;
 	
+	glColor4d(1.0, 1.0, 1.0, 0.5);
+	drawArrow(move);
+}
+
+// ******** Helpers ********
+
+// Draws the arrow for a single move
+inline void drawArrow(const BoardMove & bm)
+{
 	// Get the piece, since if its a Knight we need to draw an angle instead
 	// of drawing a direct arrow
-	const Piece * piece = move.getPiece();
-	glNormal3d(0.0, 7.0, 0.0);
-	glColor4d(1.0, 1.0, 1.0, 0.5);
+	const Piece * piece = bm.getPiece();
 	if (Piece::KNIGHT == piece->type())
-		drawAngleIron(move);
+		drawAngleIron(bm);
 	else {
-		drawArrowShaft(move);
-		drawArrowHead(move);
+		drawArrowShaft(bm);
+		drawArrowHead(bm);
 	}
 }
 
-// ******** Helpers ********
-
 // Draws the shaft of the arrow.. duh
 inline void drawArrowShaft(const BoardMove & bm)
 {
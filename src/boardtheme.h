@@ -9,6 +9,7 @@
 #ifndef BOARDTHEME_H
 #define BOARDTHEME_H
  
+#include "boardmove.h"
 #include "boardposition.h"
 #include "chessgamestate.h"
 
@@ -42,9 +43,18 @@ class BoardTheme {
     /** Toggles the drawing of history arrows on and off */
     void toggleHistoryArrows();
 
+	/** Sets the move to suggest with a hint arrow, an invalid move for none. */
+	void setHint(const BoardMove & bm)
+		{ m_hint = bm; }
+
  protected:
-	/** Draws arrows indicating the last moves made for a BoardTheme */
+	/**
+	 * Draws arrows indicating the last moves made for a BoardTheme, and the
+	 * hint if there is one
+	 */
 	virtual void drawMoveArrows(const ChessGameState & cgs);
+
+	BoardMove m_hint;
 };
 
 #define INBOARDTHEME_H
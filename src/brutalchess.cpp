@@ -232,6 +232,14 @@ int main(int argc, char *argv[])
 
 	ChessPlayer* player1 = toPlayer(opts->player1);
 	ChessPlayer* player2 = toPlayer(opts->player2);
+	BrutalPlayer* brutal = dynamic_cast<BrutalPlayer*>(player1);
+	if (brutal) {
+		brutal->setDifficulty(opts->player1diff);
+	}
+	brutal = dynamic_cast<BrutalPlayer*>(player2);
+	if (brutal) {
+		brutal->setDifficulty(opts->player2diff);
+	}
 	BoardTheme* boardTheme = toBoard(opts->board);
 	PieceSet* pieceSet = toPieces(opts->pieces);
 
@@ -8,355 +8,1171 @@
 
 #include "board.h"
 #include "chessplayer.h"
+#include "egtb.h"
+#include "matesearch.h"
+#include "openingbook.h"
 #include "options.h"
+#include "pawntable.h"
+#include "transtable.h"
+#include "SDL.h"
+#include "SDL_thread.h"
 
-#include <vector>
-#include <time.h>
 #include <climits>
+#include <cstdlib>
+#include <iostream>
+#include <time.h>
+#include <vector>
 
 using namespace std;
 
+// Selective search parameters
+static const int NULL_MOVE_MIN_DEPTH = 3;
+static const int LMR_MIN_DEPTH = 3;
+static const int LMR_FULL_DEPTH_MOVES = 3;
+static const int FUTILITY_MARGIN = 200;
+static const int RAZOR_MARGIN = 350;
+
+// Ordering score of killer moves, below every capture but above quiet moves
+static const int KILLER_SCORE = 50;
+
+// Largest history score, the scores are halved when one gets past it. Quiet
+// moves are ordered by history less this, so they stay below the killers.
+static const int HISTORY_MAX = 1 << 16;
+
+// Nodes between checks of the clock and interrupt flag, less one
+static const unsigned long STOP_POLL_MASK = 1023;
+
+// Score of a win the endgame tables have found, less the plies to mate so
+// quicker mates score higher
+static const int TABLEBASE_WIN = 50000;
+
+static int tablebaseScore(EndgameTables::Result result, int plies, int ply)
+{
+	switch(result) {
+		case EndgameTables::WIN:
+			return TABLEBASE_WIN - ply - plies;
+		case EndgameTables::LOSS:
+			return -(TABLEBASE_WIN - ply - plies);
+		default:
+			return 0;
+	}
+}
+
+// Score of mating at the root, less the plies to mate so quicker mates
+// score higher. Above every tablebase win, a mate on the board is surer.
+static const int MATE_SCORE = 100000;
+
+// Scores past this are wins or losses a known number of plies from the root
+static const int WIN_BOUND = TABLEBASE_WIN - 1000;
+
+// Wins and losses go in the table counted from the position rather than the
+// root, so they are still right when it comes up again at another ply
+static int scoreToTable(int score, int ply)
+{
+	if(score >= WIN_BOUND) {
+		return score + ply;
+	} else if(score <= -WIN_BOUND) {
+		return score - ply;
+	}
+	return score;
+}
+
+static int scoreFromTable(int score, int ply)
+{
+	if(score >= WIN_BOUND) {
+		return score - ply;
+	} else if(score <= -WIN_BOUND) {
+		return score + ply;
+	}
+	return score;
+}
+
 BrutalPlayer::BrutalPlayer()
 {
-    m_ply = Options::getInstance()->brutalplayer2ply;
+	m_ply = DEFAULT_PLY_DEPTH;
+	m_threads = Options::getInstance()->searchthreads;
+	m_multipv = 1;
+	m_pvcolor = Piece::WHITE;
+	m_fifty = 0;
 	m_trustworthy = true;
+	m_nullmove = true;
+	m_lmr = true;
+	m_futility = true;
+	m_razoring = true;
+	m_stop = false;
+	m_movetime = 0;
+	m_deadline = 0;
+	m_maxnodes = 0;
+	m_nodelimit = 0;
+	m_noise = 0;
+	m_ponder = Options::getInstance()->ponder;
+	m_usebook = true;
+	m_usetables = true;
+	m_tables = EndgameTables::getInstance();
+	m_usenetwork = true;
+	m_network = Network::getInstance();
+	m_matemoves = Options::getInstance()->matesearch;
+	m_matesearch = new MateSearch();
+	m_ponderthread = NULL;
+	m_ponder_key = 0;
+	m_ponder_move = TranspositionTable::NO_MOVE;
+	m_ponder_score = 0;
+	m_ponder_depth = 0;
+	m_analysing = false;
+	m_tt = new TranspositionTable();
+	m_ponderer = new SearchThread();
 	srand(time(NULL));
+	m_noiseseed = ((unsigned long long)rand() << 32) ^ rand();
+}
+
+BrutalPlayer::~BrutalPlayer()
+{
+	stopPondering();
+	for(int i=0; i < (int)m_searchers.size(); i++) {
+		delete m_searchers[i];
+	}
+	delete m_ponderer;
+	delete m_matesearch;
+	delete m_tt;
+}
+
+void BrutalPlayer::newGame()
+{
+	stopPondering();
+	m_noiseseed = ((unsigned long long)rand() << 32) ^ rand();
+}
+
+void BrutalPlayer::opponentMove(const BoardMove & move, const ChessGameState & cgs)
+{
+	if(m_ponderthread && cgs.getBoard().hashKey(getColor()) != m_ponder_key) {
+		stopPondering();
+	}
+}
+
+void BrutalPlayer::undoMove()
+{
+	// The table, history and last line are all kept, so thinking about the
+	// position again starts from everything learned the first time
+	stopPondering();
+}
+
+void BrutalPlayer::interruptThinking()
+{
+	ChessPlayer::interruptThinking();
+	m_stop = true;
+}
+
+void BrutalPlayer::setHashSize(int megabytes)
+{
+	m_tt->resize(megabytes);
+}
+
+void BrutalPlayer::setClock(unsigned int remaining, unsigned int increment)
+{
+	// Never plan on more than half of what's left, the increment may not
+	// come back in time to save a short clock
+	Uint32 budget = remaining / MOVES_TO_GO + increment;
+	if(budget > remaining / 2) {
+		budget = remaining / 2;
+	}
+	m_movetime = (budget > 0) ? budget : 1;
+}
+
+void BrutalPlayer::setMaxNodes(unsigned long nodes)
+{
+	m_maxnodes = nodes;
+	unsigned long mate = MateSearch::DEFAULT_NODES;
+	m_matesearch->setMaxNodes((nodes && nodes < mate) ? nodes : mate);
+}
+
+void BrutalPlayer::setDifficulty(Difficulty level)
+{
+	const DifficultyProfile & profile = Options::getInstance()->profiles[level];
+	m_ply = MAX_DEPTH - 1;
+	setMaxNodes(profile.nodes);
+	m_movetime = profile.movetime;
+	setEvalNoise(profile.noise);
 }
 
 void BrutalPlayer::think(const ChessGameState & cgs)
 {
 	BoardMove move;
-    Board board = cgs.getBoard();
-	search(board, getColor(), m_ply, -INT_MAX, INT_MAX, move);
+	Board board = cgs.getBoard();
+	const vector<unsigned long long> & keys = cgs.getKeyHistory();
+	m_gamekeys.assign(keys.begin(), keys.empty() ? keys.end() : keys.end() - 1);
+	m_fifty = cgs.getFiftyMoveCount();
+	m_stats.reset();
+	m_lines.clear();
+	m_is_thinking = true;
+	Uint32 start = SDL_GetTicks();
+
+	// On a ponder hit the search already done on the opponent's time is
+	// carried on from the last depth it completed.
+	int firstdepth = 1;
+	bool ponderhit = m_ponderthread && !m_analysing && board.hashKey(getColor()) == m_ponder_key;
+	stopPondering();
+
+	// Book moves, positions the endgame tables have solved and forced
+	// mates are played without searching at all
+	BoardMove known;
+	known.invalidate();
+	unsigned long matenodes = 0;
+	if(m_usebook) {
+		known = OpeningBook::getInstance()->probe(board, getColor());
+	}
+	if(!known.isValid() && m_usetables) {
+		known = tablebaseMove(board);
+	}
+	if(!known.isValid() && m_matemoves > 0) {
+		m_stop = m_interrupted;
+		m_matesearch->mateIn(board, getColor(), m_matemoves, known, &m_stop);
+		matenodes = m_matesearch->nodes();
+	}
+	if(known.isValid()) {
+		m_move = known;
+		m_stats.nodes = matenodes;
+		m_stats.time = SDL_GetTicks() - start;
+		m_is_thinking = false;
+		if(m_ponder && !m_interrupted) {
+			startPondering(board, known);
+		}
+		return;
+	}
+
+	if(ponderhit && m_ponder_depth > 0) {
+		move = TranspositionTable::unpackMove(m_ponder_move, board);
+		if(move.isValid()) {
+			firstdepth = m_ponder_depth + 1;
+		}
+	}
+
+	// A position searched before, e.g. before an undo, carries on from the
+	// deepest search of it the table still has
+	int hashDepth, hashScore, hashMove;
+	TranspositionTable::Bound hashBound;
+	if(!move.isValid() && m_tt->probe(board.hashKey(getColor()), hashDepth, hashScore, hashBound, hashMove) &&
+	   hashBound == TranspositionTable::EXACT) {
+		move = TranspositionTable::unpackMove(hashMove, board);
+		if(move.isValid() && move.getPiece()->color() == getColor() && board.isMoveLegal(move)) {
+			firstdepth = min(hashDepth, m_ply + 1);
+		} else {
+			move.invalidate();
+		}
+	}
+	m_deadline = m_movetime ? start + m_movetime : 0;
+	m_nodelimit = m_maxnodes;
+	m_stop = m_interrupted;
+	m_tt->newSearch();
+	restorePV();
+
+	// The search threads and their stacks are kept from move to move
+	while((int)m_searchers.size() < m_threads) {
+		m_searchers.push_back(new SearchThread());
+	}
+	for(int i=0; i < m_threads; i++) {
+		m_searchers[i]->prepare(this, i, board, getColor(), m_gamekeys, m_fifty);
+	}
+
+	// Lazy SMP, the helpers search the same position on their own stacks
+	// and only cooperate through the transposition table.
+	vector<SDL_Thread*> handles;
+	for(int i=1; i < m_threads; i++) {
+		SDL_Thread * thread = SDL_CreateThread(helperThread, m_searchers[i]);
+		if(thread == NULL) {
+			cerr << "Unable to create search thread: " << SDL_GetError() << endl;
+			break;
+		}
+		handles.push_back(thread);
+	}
+
+	SearchThread & main = *m_searchers[0];
+	main.stats.depth = firstdepth - 1;
+	main.multipv = m_multipv;
+
+	// Iterative deepening, each iteration leaves better move ordering in the
+	// table for the next. The search evaluates at depth 0 rather than one
+	// ply into the move loop, so go one deeper than m_ply to keep the same
+	// horizon.
+	for(int depth = firstdepth; depth <= m_ply + 1 && !m_stop; depth++) {
+		search(main, getColor(), depth, 0, -INT_MAX, INT_MAX, false);
+		BoardMove best = main.pvlength[0] ? main.pv[0][0] : BoardMove();
+
+		// A stopped iteration only got through some of the moves, so its
+		// answer is only used when there's nothing better to fall back on.
+		if(m_stop && move.isValid()) {
+			break;
+		}
+		move = best;
+		if(!m_stop) {
+			main.stats.depth = depth;
+			m_lines = main.lines;
+			m_pvboard = board;
+			m_pvcolor = getColor();
+			m_pv.clear();
+			for(int i = 0; i < main.pvlength[0]; i++) {
+				m_pv.push_back(TranspositionTable::packMove(main.pv[0][i]));
+			}
+		}
+	}
+
+	m_stop = true;
+	for(int i=0; i < (int)handles.size(); i++) {
+		SDL_WaitThread(handles[i], NULL);
+	}
+
+	m_stats = main.stats;
+	for(int i=1; i <= (int)handles.size(); i++) {
+		m_stats += m_searchers[i]->stats;
+	}
+	// The mate search that found nothing still cost its nodes
+	m_stats.nodes += matenodes;
+	// Helpers run ahead of the main thread, report what was actually played
+	m_stats.depth = main.stats.depth;
+	m_stats.time = SDL_GetTicks() - start;
 	m_move = move;
+	m_deadline = 0;
+	m_nodelimit = 0;
+	m_is_thinking = false;
+
+	if(m_ponder && move.isValid() && !m_interrupted) {
+		startPondering(board, move);
+	}
+}
+
+BoardMove BrutalPlayer::tablebaseMove(const Board & board)
+{
+	BoardMove best;
+	best.invalidate();
+
+	Piece::Color color = getColor(), opponent = Piece::opposite(color);
+	EndgameTables::Result result;
+	int plies;
+	if(m_tables->size() == 0 || !m_tables->probe(board, color, result, plies)) {
+		return best;
+	}
+
+	BoardMove moves[Board::MAX_MOVES];
+	int count = board.generateMoves(color, moves);
+	int bestScore = -INT_MAX;
+	for(int i=0; i < count; i++) {
+		Board child = board;
+		child.update(moves[i]);
+		if(child.isCheck(color)) {
+			continue;
+		}
+		// A move the tables can't judge, e.g. one allowing en passant,
+		// leaves it to the search
+		if(!m_tables->probe(child, opponent, result, plies)) {
+			best.invalidate();
+			return best;
+		}
+		int score = -tablebaseScore(result, plies, 1);
+		if(score > bestScore) {
+			bestScore = score;
+			best = moves[i];
+		}
+	}
+	return best;
+}
+
+int BrutalPlayer::helperThread(void * data)
+{
+	SearchThread * st = (SearchThread*)data;
+	BrutalPlayer * player = st->player;
+
+	// Odd helpers run a ply ahead of the even ones so the threads spread
+	// over neighbouring depths instead of all searching the same tree.
+	for(int depth = 1 + st->id % 2; depth <= MAX_DEPTH && !player->m_stop; depth++) {
+		player->search(*st, st->color, depth, 0, -INT_MAX, INT_MAX, false);
+	}
+	return 0;
+}
+
+// Adds the position before move to the keys that could repeat, or clears
+// them if move can't be undone, and counts it towards the fifty move rule
+static void addKey(vector<unsigned long long> & keys, int & fifty, const Board & board,
+                   Piece::Color color, const BoardMove & move)
+{
+	if(board.getPiece(move.origin())->type() == Piece::PAWN || board.isOccupied(move.dest())) {
+		keys.clear();
+		fifty = 0;
+	} else {
+		keys.push_back(board.hashKey(color));
+		fifty++;
+	}
+}
+
+void BrutalPlayer::startPondering(const Board & board, const BoardMove & move)
+{
+	stopPondering();
+
+	vector<unsigned long long> keys = m_gamekeys;
+	int fifty = m_fifty;
+	addKey(keys, fifty, board, getColor(), move);
+	Board after = board;
+	after.update(move);
+
+	// The expected reply is the best move the search found for the
+	// opponent, if it got far enough to store one.
+	Piece::Color opponent = Piece::opposite(getColor());
+	int hashDepth, hashScore, hashMove;
+	TranspositionTable::Bound hashBound;
+	if(!m_tt->probe(after.hashKey(opponent), hashDepth, hashScore, hashBound, hashMove)) {
+		return;
+	}
+	BoardMove guess = TranspositionTable::unpackMove(hashMove, after);
+	if(!guess.isValid() || guess.getPiece()->color() != opponent || !after.isMoveLegal(guess)) {
+		return;
+	}
+	addKey(keys, fifty, after, opponent, guess);
+	after.update(guess);
+
+	m_ponderer->prepare(this, 0, after, getColor(), keys, fifty);
+	m_ponder_key = after.hashKey(getColor());
+	m_ponder_move = TranspositionTable::NO_MOVE;
+	m_ponder_depth = 0;
+	m_stop = false;
+
+	m_ponderthread = SDL_CreateThread(ponderThread, this);
+	if(m_ponderthread == NULL) {
+		cerr << "Unable to create ponder thread: " << SDL_GetError() << endl;
+	}
+}
+
+void BrutalPlayer::startAnalysis(const ChessGameState & cgs)
+{
+	const Board & board = cgs.getBoard();
+	Piece::Color color = cgs.getTurn();
+	if(m_ponderthread && m_analysing && board.hashKey(color) == m_ponder_key) {
+		return;
+	}
+	stopPondering();
+
+	// Positions earlier in the game can be repeated, as in think
+	const vector<unsigned long long> & keys = cgs.getKeyHistory();
+	vector<unsigned long long> gamekeys(keys.begin(), keys.empty() ? keys.end() : keys.end() - 1);
+	m_ponderer->prepare(this, 0, board, color, gamekeys, cgs.getFiftyMoveCount());
+	m_ponder_key = board.hashKey(color);
+	m_ponder_move = TranspositionTable::NO_MOVE;
+	m_ponder_depth = 0;
+	m_analysing = true;
+	m_stop = false;
+
+	m_ponderthread = SDL_CreateThread(ponderThread, this);
+	if(m_ponderthread == NULL) {
+		cerr << "Unable to create analysis thread: " << SDL_GetError() << endl;
+	}
+}
+
+bool BrutalPlayer::getAnalysis(const Board & board, Piece::Color color, BoardMove & move,
+                               int & score, int & depth) const
+{
+	if(!m_ponderthread || !m_analysing || board.hashKey(color) != m_ponder_key) {
+		return false;
+	}
+
+	// Read the depth first, the move and score are at least that deep
+	depth = m_ponder_depth;
+	score = m_ponder_score;
+	move = TranspositionTable::unpackMove(m_ponder_move, board);
+	return depth > 0 && move.isValid();
+}
+
+void BrutalPlayer::stopPondering()
+{
+	if(m_ponderthread) {
+		m_stop = true;
+		SDL_WaitThread(m_ponderthread, NULL);
+		m_ponderthread = NULL;
+	}
+	m_analysing = false;
+}
+
+int BrutalPlayer::ponderThread(void * data)
+{
+	BrutalPlayer * player = (BrutalPlayer*)data;
+	SearchThread & st = *player->m_ponderer;
+
+	// Keep deepening until told to stop, only iterations that finished are
+	// worth handing over on a ponder hit.
+	for(int depth = 1; depth <= MAX_DEPTH && !player->m_stop; depth++) {
+		int score = player->search(st, st.color, depth, 0, -INT_MAX, INT_MAX, false);
+		if(!player->m_stop && st.pvlength[0]) {
+			player->m_ponder_move = TranspositionTable::packMove(st.pv[0][0]);
+			player->m_ponder_score = score;
+			player->m_ponder_depth = depth;
+		}
+	}
+	return 0;
+}
+
+bool BrutalPlayer::isStopped(SearchThread & st)
+{
+	unsigned long nodes = st.stats.totalNodes();
+	if(!m_stop && (nodes & STOP_POLL_MASK) == 0) {
+		// Helpers would each spend the node budget again, so only the main
+		// thread's nodes count
+		if(m_interrupted || (m_deadline && SDL_GetTicks() >= m_deadline) ||
+		   (m_nodelimit && st.id == 0 && nodes >= m_nodelimit)) {
+			m_stop = true;
+		}
+	}
+	return m_stop;
+}
+
+bool BrutalPlayer::isRepetition(const SearchThread & st, int ply) const
+{
+	if(st.fifty[ply] >= 100) {
+		return true;
+	}
+
+	// A position can only come back with the same side to move, and at
+	// least two moves each later
+	int index = st.gamekeys + ply;
+	int oldest = max(0, index - st.fifty[ply]);
+	for(int i = index - 4; i >= oldest; i -= 2) {
+		if(st.keys[i] == st.keys[index]) {
+			return true;
+		}
+	}
+	return false;
 }
 
-int BrutalPlayer::search(Board board, Piece::Color color, int depth, int alpha, int beta, BoardMove& move)
+int BrutalPlayer::search(SearchThread & st, Piece::Color color, int depth, int ply, int alpha, int beta, bool allownull)
 {
-	BoardMove testMove;
-	Board testBoard = board;
+	st.pvlength[ply] = 0;
+
+	if(isStopped(st)) {
+		return 0;
+	}
+
+	if(depth <= 0) {
+		return quiesce(st, color, ply, alpha, beta);
+	}
+
+	const Board & board = st.stack[ply];
+	if(ply >= MAX_PLY - 1) {
+		return evaluate(st, ply, color);
+	}
+
+	st.stats.nodes++;
+	if(ply > st.stats.seldepth) {
+		st.stats.seldepth = ply;
+	}
+
+	// A repetition or the fifty move rule ends the game here, whatever the
+	// table says about the position
+	unsigned long long key = board.hashKey(color);
+	st.keys[st.gamekeys + ply] = key;
+	if(ply > 0 && isRepetition(st, ply)) {
+		st.stats.repetitions++;
+		return 0;
+	}
+
+	// Use what any thread has already learned about this position
+	int hashDepth, hashScore, hashMove = TranspositionTable::NO_MOVE;
+	TranspositionTable::Bound hashBound;
+	st.stats.tt_probes++;
+	bool hashHit = m_tt->probe(key, hashDepth, hashScore, hashBound, hashMove);
+	if(hashHit) {
+		st.stats.tt_hits++;
+		hashScore = scoreFromTable(hashScore, ply);
+	}
+	if(hashHit && ply > 0 && hashDepth >= depth) {
+		if(hashBound == TranspositionTable::EXACT) {
+			return (hashScore < alpha) ? alpha : (hashScore > beta) ? beta : hashScore;
+		}
+		if(hashBound == TranspositionTable::LOWER && hashScore >= beta) {
+			return beta;
+		}
+		if(hashBound == TranspositionTable::UPPER && hashScore <= alpha) {
+			return alpha;
+		}
+	}
+
+	// The endgame tables know the exact score, there's nothing to search
+	EndgameTables::Result tbresult;
+	int tbplies;
+	if(ply > 0 && m_usetables && m_tables->size() > 0 &&
+	   m_tables->probe(board, color, tbresult, tbplies)) {
+		st.stats.tb_hits++;
+		int score = tablebaseScore(tbresult, tbplies, ply);
+		return (score < alpha) ? alpha : (score > beta) ? beta : score;
+	}
+
+	Piece::Color opponent = Piece::opposite(color);
+	bool incheck = board.isCheck(color);
+	Board & child = st.stack[ply+1];
+
+	// Null move pruning, if we can pass and still fail high there is no need
+	// to search this node. Passing is a bad guess when all that's left is
+	// pawns since zugzwang is common there.
+	if(m_nullmove && allownull && !incheck && depth >= NULL_MOVE_MIN_DEPTH &&
+	   board.hasNonPawnMaterial(color)) {
+		child = board;
+		child.makeNullMove(color);
+		st.fifty[ply+1] = 0;
+		int reduction = (depth > 6) ? 3 : 2;
+		int nullScore = -search(st, opponent, depth-1-reduction, ply+1, -beta, -beta+1, false);
+		if(m_stop) {
+			return 0;
+		}
+		if(nullScore >= beta) {
+			st.stats.null_cutoffs++;
+			return beta;
+		}
+	}
+
+	// Razoring and futility pruning near the leaves, both based on the
+	// static evaluation being far below alpha.
+	bool futile = false;
+	int futilityScore = -INT_MAX;
+	if(!incheck && depth <= 2 && (m_futility || m_razoring)) {
+		int staticEval = evaluate(st, ply, color);
+		if(m_razoring && depth == 2 && staticEval + RAZOR_MARGIN <= alpha) {
+			int score = quiesce(st, color, ply, alpha, beta);
+			if(m_stop) {
+				return 0;
+			}
+			if(score <= alpha) {
+				st.stats.razor_cutoffs++;
+				return score;
+			}
+		}
+		if(m_futility && depth == 1 && staticEval + FUTILITY_MARGIN <= alpha) {
+			futile = true;
+			futilityScore = staticEval + FUTILITY_MARGIN;
+		}
+	}
+
 	int moveScore, bestScore = -INT_MAX;
-	vector<BoardMove> moves = board.possibleMoves(color);
+	int alphaOrig = alpha;
+	bool multipv = (ply == 0 && st.multipv > 1);
+	if(multipv) {
+		st.lines.clear();
+	}
+	BoardMove * moves = st.moves[ply];
+	int count = board.generateMoves(color, moves);
+	orderMoves(st, ply, count, hashMove);
 
 	bool gotmove = false;
+	int searched = 0;
 
-	for(int i=0; i < moves.size(); i++) {
-		if(!board.isMoveLegal(moves[i])) {
+	for(int i=0; i < count; i++) {
+		// The generator leaves it to us to reject moves into check
+		child = board;
+		child.update(moves[i]);
+		if(child.isCheck(color)) {
 			continue;
 		}
 
 		if(!gotmove) {
-			move = moves[i];
+			st.pv[ply][0] = moves[i];
+			st.pvlength[ply] = 1;
 			gotmove = true;
 		}
 
-		testBoard = board;
-		testBoard.update(moves[i]);
-	
-        if(depth == 0) {
-			moveScore = evaluateBoard(testBoard, color);
+		bool capture = isCapture(board, moves[i]);
+		bool quiet = !capture && moves[i].getPromotion() == Piece::NOTYPE;
+		bool givescheck = child.isCheck(opponent);
+		st.fifty[ply+1] = (capture || moves[i].getPiece()->type() == Piece::PAWN) ? 0 : st.fifty[ply] + 1;
+
+		// Quiet moves can't bring a hopeless frontier node back up to alpha
+		if(futile && quiet && !givescheck) {
+			st.stats.futility_pruned++;
+			if(futilityScore > bestScore) {
+				bestScore = futilityScore;
+			}
+			continue;
+		}
+
+		if(searched == 0) {
+			moveScore = -search(st, opponent, depth-1, ply+1, -beta, -alpha);
+		} else if(m_lmr && quiet && !incheck && !givescheck &&
+		          depth >= LMR_MIN_DEPTH && searched >= LMR_FULL_DEPTH_MOVES) {
+			// Late quiet moves rarely turn out best, try them shallower first
+			int reduction = (searched >= 2*LMR_FULL_DEPTH_MOVES && depth > 4) ? 2 : 1;
+			st.stats.lmr_reductions++;
+			moveScore = -search(st, opponent, depth-1-reduction, ply+1, -alpha-1, -alpha);
+			if(moveScore > alpha && !m_stop) {
+				st.stats.lmr_researches++;
+				moveScore = -search(st, opponent, depth-1, ply+1, -beta, -alpha);
+			}
 		} else {
-			moveScore = -search(testBoard, Piece::opposite(color), depth-1, -beta, -alpha, testMove);
+			moveScore = -search(st, opponent, depth-1, ply+1, -beta, -alpha);
+		}
+		searched++;
+
+		// An interrupted search returns junk, don't let it near the table
+		if(m_stop) {
+			return 0;
 		}
 
-        if(moveScore > bestScore) {
+		if(moveScore > bestScore) {
 			bestScore = moveScore;
-			move = moves[i];
-        }
-        if(bestScore > alpha) {
+			updatePV(st, ply, moves[i]);
+		}
+
+		// Every root move that makes the list needs an exact score, so alpha
+		// is the worst of the lines rather than the best
+		if(multipv) {
+			if(moveScore > alpha) {
+				addLine(st, moves[i], moveScore, depth);
+				if((int)st.lines.size() == st.multipv) {
+					alpha = st.lines.back().score;
+				}
+			}
+			continue;
+		}
+
+		if(bestScore > alpha) {
 			alpha = bestScore;
 		}
-        if(alpha >= beta) {
+		if(alpha >= beta) {
+			st.stats.beta_cutoffs++;
+			if(searched == 1) {
+				st.stats.first_move_cutoffs++;
+			}
+			if(quiet) {
+				int killer = TranspositionTable::packMove(moves[i]);
+				if(st.killers[ply][0] != killer) {
+					st.killers[ply][1] = st.killers[ply][0];
+					st.killers[ply][0] = killer;
+				}
+				int & history = st.history[color][moves[i].origin().hash()][moves[i].dest().hash()];
+				history += depth * depth;
+				if(history > HISTORY_MAX) {
+					st.ageHistory();
+				}
+			}
+			m_tt->store(key, depth, scoreToTable(beta, ply), TranspositionTable::LOWER,
+			            TranspositionTable::packMove(moves[i]));
 			return beta;
 		}
 	}
-	
+
+	// With no legal move the game is over, lost if in check and drawn if not
+	if(!gotmove) {
+		return incheck ? -(MATE_SCORE - ply) : 0;
+	}
+
+	if(bestScore > alphaOrig) {
+		m_tt->store(key, depth, scoreToTable(bestScore, ply), TranspositionTable::EXACT,
+		            TranspositionTable::packMove(st.pv[ply][0]));
+	} else {
+		m_tt->store(key, depth, scoreToTable(bestScore, ply), TranspositionTable::UPPER,
+		            TranspositionTable::NO_MOVE);
+	}
+
 	return bestScore;
 }
 
-int BrutalPlayer::evaluateBoard(const Board & board, Piece::Color turn)
-{
-    vector< vector<BoardPosition> > locations(Piece::LAST_TYPE+1);
-    
-    // Raw material balance
-    int balance = 0;
-    int endgamecount = 0;
-            
-    int queenval = 900, rookval = 500, bishopval = 325, knightval = 310, pawnval = 100, kingval = 100000;
-    
-    for(int i=0; i < 64; i++) {
-        BoardPosition bp = BoardPosition(i);
-        if(board.isOccupied(bp)) {
-            Piece *p = board.getPiece(bp);
-            switch(p->type()) {
-                case Piece::QUEEN:
-                    locations[Piece::QUEEN].push_back(bp);
-                    balance += (p->color() == turn) ? queenval : -queenval;
-                    endgamecount += queenval;
-                    break;
-                case Piece::ROOK:
-                    locations[Piece::ROOK].push_back(bp);
-                    balance += (p->color() == turn) ? rookval : -rookval;
-                    endgamecount += rookval;
-                    break;
-                case Piece::BISHOP:
-                    locations[Piece::BISHOP].push_back(bp);
-                    balance += (p->color() == turn) ? bishopval : -bishopval;
-                    endgamecount += bishopval;
-                    break;
-                case Piece::KNIGHT:
-                    locations[Piece::KNIGHT].push_back(bp);
-                    balance += (p->color() == turn) ? knightval : -knightval;
-                    endgamecount += knightval;
-                    break;
-                case Piece::PAWN:
-                    locations[Piece::PAWN].push_back(bp);
-                    balance += (p->color() == turn) ? pawnval : -pawnval;
-                    endgamecount += pawnval;
-                    break;
-                case Piece::KING:
-                    locations[Piece::KING].push_back(bp);
-                    if ((p->color() == turn) && !board.isCheckMate(turn)) {
-                        balance += kingval;
-                    }
-                    else if ((p->color() != turn) && !board.isCheckMate(turn)) {
-                        balance -= kingval;
-                    }
-                    break;
-            }
-        }
-    }
-
-    // Determine end game or not.  THIS IS A TWEAKABLE VALUE.
-    bool endgame = false;
-    if (endgamecount < 3500) {
-        endgame = true;
-    }
-
-    for(int i=0; i < locations[Piece::QUEEN].size(); i++) {
-        balance += queenBonus(locations[Piece::QUEEN][i], board, turn, endgame);
-    }
-    for(int i=0; i < locations[Piece::ROOK].size(); i++) {
-        balance += rookBonus(locations[Piece::ROOK][i], board, turn, endgame);
-    }
-    for(int i=0; i < locations[Piece::BISHOP].size(); i++) {
-        balance += bishopBonus(locations[Piece::BISHOP][i], board, turn, endgame);
-    }
-    for(int i=0; i < locations[Piece::KNIGHT].size(); i++) {
-        balance += knightBonus(locations[Piece::KNIGHT][i], board, turn, endgame);
-    }
-    for(int i=0; i < locations[Piece::PAWN].size(); i++) {
-        balance += pawnBonus(locations[Piece::PAWN][i], board, turn, endgame);
-    }
-    for(int i=0; i < locations[Piece::KING].size(); i++) {
-        balance += kingBonus(locations[Piece::KING][i], board, turn, endgame);
-    }
-
-    return balance;
-}
-
-// Queen Bonuses are finished, queens get bonuses for being near an opposing king.
-int BrutalPlayer::queenBonus(const BoardPosition & bp, const Board & board, Piece::Color turn, bool endgame) {
-	if (!endgame) {
-        return 0;
-	}
-
-    Piece * p = board.getPiece(bp);
-    int bonus = 0;
-	BoardMove dist;
-    
-    if (p->color() == Piece::WHITE) {
-        dist = BoardMove(bp, board.getKing(Piece::BLACK), p);
-	}
-	else {
-		dist = BoardMove(bp, board.getKing(Piece::WHITE), p);
-	}
-
-	bonus = -2*abs(dist.fileDiff()+dist.rankDiff());
-
-    return (turn == p->color()) ? bonus : -bonus;
-}
-
-int BrutalPlayer::rookBonus(const BoardPosition & bp, const Board & board, Piece::Color turn, bool endgame) {
-    int bonus = 0;
-
-	// Rooks get a bonus of 0 points if blocked, or up to 20 points if
-	// attacking 12 squares or more.
-	unsigned long long rookAttacks = Board::rankAttacks[bp.hash()][board.getRankState(bp)] ||
-                                     Board::fileAttacks[bp.hash()][board.getFileState(bp)];
-    int numAttacked = numAttackedSquares(rookAttacks);
-    bonus += (numAttacked < 12) ? 2*numAttacked-4 : 20;
+// Searches captures and queen promotions until the position is quiet, so
+// the static evaluation is never taken in the middle of an exchange.
+int BrutalPlayer::quiesce(SearchThread & st, Piece::Color color, int ply, int alpha, int beta)
+{
+	st.pvlength[ply] = 0;
+
+	if(isStopped(st)) {
+		return 0;
+	}
+
+	st.stats.qnodes++;
+	if(ply > st.stats.seldepth) {
+		st.stats.seldepth = ply;
+	}
+
+	const Board & board = st.stack[ply];
+	bool incheck = board.isCheck(color);
+
+	// Standing pat in check would miss mates, so every evasion is searched
+	if(!incheck) {
+		int standPat = evaluate(st, ply, color);
+		if(standPat >= beta) {
+			return beta;
+		}
+		if(standPat > alpha) {
+			alpha = standPat;
+		}
+	}
+	if(ply >= MAX_PLY - 1) {
+		return incheck ? evaluate(st, ply, color) : alpha;
+	}
+
+	BoardMove * moves = st.moves[ply];
+	int count = board.generateMoves(color, moves, !incheck);
+	orderMoves(st, ply, count, TranspositionTable::NO_MOVE);
+	Board & child = st.stack[ply+1];
+	bool gotmove = false;
+
+	for(int i=0; i < count; i++) {
+		child = board;
+		child.update(moves[i]);
+		if(child.isCheck(color)) {
+			continue;
+		}
+		gotmove = true;
+
+		int score = -quiesce(st, Piece::opposite(color), ply+1, -beta, -alpha);
+
+		if(score >= beta) {
+			return beta;
+		}
+		if(score > alpha) {
+			alpha = score;
+		}
+	}
+
+	if(incheck && !gotmove) {
+		return -(MATE_SCORE - ply);
+	}
+	return alpha;
+}
 
-    return bonus;
+void BrutalPlayer::restorePV()
+{
+	Board board = m_pvboard;
+	Piece::Color color = m_pvcolor;
+	for(int i = 0; i < (int)m_pv.size(); i++) {
+		BoardMove move = TranspositionTable::unpackMove(m_pv[i], board);
+		if(!move.isValid()) {
+			break;
+		}
+
+		// Only the move is worth anything now, so it goes in with no depth
+		// and only for positions that have lost their entry
+		unsigned long long key = board.hashKey(color);
+		int hashDepth, hashScore, hashMove;
+		TranspositionTable::Bound hashBound;
+		if(!m_tt->probe(key, hashDepth, hashScore, hashBound, hashMove)) {
+			m_tt->store(key, 0, 0, TranspositionTable::NONE, m_pv[i]);
+		}
+
+		board.update(move);
+		color = Piece::opposite(color);
+	}
 }
 
+void BrutalPlayer::updatePV(SearchThread & st, int ply, const BoardMove & move)
+{
+	st.pv[ply][0] = move;
+	for(int i=0; i < st.pvlength[ply+1]; i++) {
+		st.pv[ply][i+1] = st.pv[ply+1][i];
+	}
+	st.pvlength[ply] = st.pvlength[ply+1] + 1;
+}
 
-int BrutalPlayer::bishopBonus(const BoardPosition & bp, const Board & board, Piece::Color turn, bool endgame) {
-    Piece::Color color = board.getPiece(bp)->color();
-    int bonus = m_bishop[bp.hash()];
+void BrutalPlayer::addLine(SearchThread & st, const BoardMove & move, int score, int depth)
+{
+	int at = (int)st.lines.size();
+	while(at > 0 && st.lines[at-1].score < score) {
+		at--;
+	}
+	if(at >= st.multipv) {
+		return;
+	}
 
-    return (turn == color) ? bonus: -bonus;
+	Line line;
+	line.score = score;
+	line.depth = depth;
+	line.pv.push_back(move);
+	line.pv.insert(line.pv.end(), st.pv[1], st.pv[1] + st.pvlength[1]);
+	st.lines.insert(st.lines.begin() + at, line);
+	if((int)st.lines.size() > st.multipv) {
+		st.lines.pop_back();
+	}
 }
 
+void BrutalPlayer::orderMoves(SearchThread & st, int ply, int count, int hashmove)
+{
+	BoardMove * moves = st.moves[ply];
+	int * scores = st.scores[ply];
+	const Board & board = st.stack[ply];
 
-int BrutalPlayer::knightBonus(const BoardPosition & bp, const Board & board, Piece::Color turn, bool endgame) {
-    Piece::Color color = board.getPiece(bp)->color();
-    int bonus = m_knight[bp.hash()];
+	for(int i=0; i < count; i++) {
+		int packed = TranspositionTable::packMove(moves[i]);
+		if(hashmove != TranspositionTable::NO_MOVE && packed == hashmove) {
+			scores[i] = INT_MAX;
+			continue;
+		}
 
-	bool drivenBonus = false;
+		scores[i] = 0;
+		Piece * victim = board.getPiece(moves[i].dest());
+		if(victim) {
+			scores[i] = 10*m_value[victim->type()] - m_value[moves[i].getPiece()->type()];
+		} else if(isCapture(board, moves[i])) {
+			scores[i] = 10*m_value[Piece::PAWN] - m_value[Piece::PAWN];
+		} else if(packed == st.killers[ply][0]) {
+			scores[i] = KILLER_SCORE;
+		} else if(packed == st.killers[ply][1]) {
+			scores[i] = KILLER_SCORE - 1;
+		} else {
+			Piece::Color color = moves[i].getPiece()->color();
+			scores[i] = st.history[color][moves[i].origin().hash()][moves[i].dest().hash()] - HISTORY_MAX;
+		}
+		if(moves[i].getPromotion() == Piece::QUEEN) {
+			scores[i] += 10*m_value[Piece::QUEEN];
+		}
+	}
 
-	// Knights are given a bonus for being within 2 squares of each enemy piece.
-	
+	// Insertion sort, move lists are short and mostly quiet
+	for(int i=1; i < count; i++) {
+		BoardMove bm = moves[i];
+		int score = scores[i];
+		int j = i-1;
+		while(j >= 0 && scores[j] < score) {
+			moves[j+1] = moves[j];
+			scores[j+1] = scores[j];
+			j--;
+		}
+		moves[j+1] = bm;
+		scores[j+1] = score;
+	}
+}
 
-    return (turn == color) ? bonus : -bonus;
+bool BrutalPlayer::isCapture(const Board & board, const BoardMove & bm)
+{
+	if(board.isOccupied(bm.dest())) {
+		return true;
+	}
+	// En passant is the only capture onto an empty square
+	return bm.getPiece()->type() == Piece::PAWN && bm.fileDiff() != 0;
 }
 
-int BrutalPlayer::pawnBonus(const BoardPosition & bp, const Board & board, Piece::Color turn, bool endgame) {
-    Piece::Color color = board.getPiece(bp)->color();
-    int bonus = (color == Piece::WHITE) ? m_wpawn[bp.hash()] : m_bpawn[bp.hash()];
+// Squares of the a file, shifted across for the others
+static const unsigned long long FILE_A = 0x0101010101010101ULL;
+
+// Penalty for an isolated pawn on each file, the center ones are worse off
+static const int ISOLATED_PENALTY[8] = {12, 14, 16, 20, 20, 16, 14, 12};
+
+// Penalty for each pawn sharing its file with a friendly one
+static const int DOUBLED_PENALTY = 10;
 
-	if(isIsolatedPawn(bp, board)) {
-        char file = bp.filec();
-        if(file == 'a' || file == 'h') {
-            bonus -= 12;
-        } else if (file == 'b' || file == 'g') {
-            bonus -= 14;
-        } else if (file == 'c' || file == 'f') {
-            bonus -= 16;
-        } else if (file == 'd' || file == 'e') {
-            bonus -= 20;
-        }
-    }
-	/*
-    if(isDoubledPawn(bp, board)) {
-    }
-	*/
-    return (turn == color) ? bonus : -bonus;
+// Bonus for a passed pawn by how many ranks it has advanced
+static const int PASSED_BONUS[8] = {0, 5, 10, 20, 35, 60, 100, 0};
+
+int BrutalPlayer::evaluate(SearchThread & st, int ply, Piece::Color color)
+{
+	int score;
+	if(m_usenetwork && m_network->isLoaded()) {
+		score = evaluateNetwork(st, ply, color);
+	} else {
+		score = evaluateBoard(st, st.stack[ply], color);
+	}
+	if(m_noise) {
+		score += evalNoise(st.stack[ply], color);
+	}
+	return score;
 }
 
-int BrutalPlayer::kingBonus(const BoardPosition & bp, const Board & board, Piece::Color turn, bool endgame) {
-    Piece::Color color = board.getPiece(bp)->color();
-    int bonus = 0;
+int BrutalPlayer::evalNoise(const Board & board, Piece::Color color) const
+{
+	// Mixes the key so that positions a move apart get unrelated errors
+	unsigned long long x = board.m_hash ^ m_noiseseed;
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+	x ^= x >> 31;
+	int error = (int)(x % (2*m_noise + 1)) - m_noise;
+	return (color == Piece::WHITE) ? error : -error;
+}
 
-    // Count all pieces attacking the king
-    unsigned long long attacked = board.isAttacked(bp, color);
-    for(int i=0; i < 64; i++) {
-        bonus -= 25*((attacked >> i) & 1);
-    }
-    
-    if(endgame) {
-        bonus = m_end_king[bp.hash()];
-    } else {
-        bonus = (color == Piece::WHITE) ? m_wking[bp.hash()] : m_bking[bp.hash()];
-    }
-    
-    return (turn == color) ? bonus : -bonus;
+int BrutalPlayer::evaluateNetwork(SearchThread & st, int ply, Piece::Color color)
+{
+	// Interior nodes aren't evaluated, so find the nearest ply with sums
+	// for its position and carry them up from there, leaving sums at every
+	// ply on the way for the siblings to start from
+	int from = ply;
+	while(from >= 0 && st.accumulators[from].key != st.stack[from].m_hash) {
+		from--;
+	}
+	if(from < 0) {
+		from = 0;
+		m_network->refresh(st.stack[0], st.accumulators[0]);
+	}
+	for(; from < ply; from++) {
+		m_network->update(st.stack[from], st.stack[from+1], st.accumulators[from],
+		                  st.accumulators[from+1]);
+	}
+	return m_network->evaluate(st.accumulators[ply], color);
 }
 
-int BrutalPlayer::numAttackedSquares(const unsigned long long & pieceAttacks)
+// Blends middlegame and endgame scores by how much of the middlegame is left
+static int taper(int mg, int eg, int phase)
 {
-	int numSquares = 0;
-	for (int i = 0; i < 64; i++) {
-		if (pieceAttacks && (1LL << i)) {
-			numSquares++;
-		}
+	return (mg*phase + eg*(Board::MAX_PHASE - phase)) / Board::MAX_PHASE;
+}
+
+int BrutalPlayer::evaluateBoard(SearchThread & st, const Board & board, Piece::Color turn)
+{
+	Piece::Color other = Piece::opposite(turn);
+
+	// Material and piece-square bonuses are kept up to date by the board,
+	// only the terms that depend on more than one piece are worked out here
+	int mg = board.score(turn, Board::MIDDLEGAME) - board.score(other, Board::MIDDLEGAME);
+	int eg = board.score(turn, Board::ENDGAME) - board.score(other, Board::ENDGAME);
+	eg += queenBonus(board, turn) - queenBonus(board, other);
+	int balance = taper(mg, eg, board.phase());
+
+	balance += rookBonus(board, turn) - rookBonus(board, other);
+
+	// The pawns rarely change, so their structure is nearly always cached
+	const PawnTable::Entry & pawns = probePawns(st, board);
+	balance += (turn == Piece::WHITE) ? pawns.score : -pawns.score;
+
+	return balance;
+}
+
+void BrutalPlayer::evaluateBatch(const Board * boards, int n, int * out, const Piece::Color * turns)
+{
+	if(m_usenetwork && m_network->isLoaded()) {
+		m_network->evaluateBatch(boards, n, out, turns);
+		return;
+	}
+
+	// The pawn structures are cached in the main search thread's table
+	if(m_searchers.empty()) {
+		m_searchers.push_back(new SearchThread());
+	}
+	SearchThread & st = *m_searchers[0];
+
+	// One board at a time, gathering the terms into arrays for the compiler
+	// to vectorise measured no faster as the time goes in the bitboards.
+	for(int i = 0; i < n; i++) {
+		out[i] = evaluateBoard(st, boards[i], turns ? turns[i] : Piece::WHITE);
 	}
-	return numSquares;
 }
 
-bool BrutalPlayer::isIsolatedPawn(const BoardPosition & bp, const Board & board)
+#ifndef NDEBUG
+void BrutalPlayer::printEvaluation(ostream & out, const Board & board, Piece::Color turn)
 {
-        Piece::Color c = board.getPiece(bp)->color();
-	unsigned long long mask = board.m_color[c] & board.m_pieces[Piece::PAWN];
+	Piece::Color other = Piece::opposite(turn);
+	int phase = board.phase();
 
-	BoardPosition test = bp.E();
-	if(test.isValid() && (mask & maskFile(test))) {
-		return false;
+	PawnTable::Entry pawns;
+	evaluatePawns(board, pawns);
+	int pawnscore = (turn == Piece::WHITE) ? pawns.score : -pawns.score;
+	int material = board.material(turn) - board.material(other);
+	int rooks = rookBonus(board, turn) - rookBonus(board, other);
+
+	// Middlegame and endgame score of each term, for the side to move
+	int terms[5][2] = {
+		{ material, material },
+		{ board.score(turn, Board::MIDDLEGAME) - board.score(other, Board::MIDDLEGAME) - material,
+		  board.score(turn, Board::ENDGAME) - board.score(other, Board::ENDGAME) - material },
+		{ 0, queenBonus(board, turn) - queenBonus(board, other) },
+		{ rooks, rooks },
+		{ pawnscore, pawnscore }
+	};
+	const char * names[5] = { "Material", "Piece-square", "Queens", "Rooks", "Pawns" };
+
+	out << "Phase " << phase << "/" << Board::MAX_PHASE << ", "
+	    << (turn == Piece::WHITE ? "white" : "black") << " to move" << endl;
+	int mg = 0, eg = 0;
+	for(int i = 0; i < 5; i++) {
+		out << names[i] << ": " << terms[i][0] << " middlegame, " << terms[i][1]
+		    << " endgame" << endl;
+		if(i < 3) {
+			mg += terms[i][0];
+			eg += terms[i][1];
+		}
 	}
+	out << "Total: " << taper(mg, eg, phase) + rooks + pawnscore << endl;
+}
+#endif
 
-	test = bp.W();
-	if(test.isValid() && (mask & maskFile(test))) {
-		return false;
+const PawnTable::Entry & BrutalPlayer::probePawns(SearchThread & st, const Board & board)
+{
+	unsigned long long key = board.pawnKey();
+	PawnTable::Entry & entry = st.pawns.lookup(key);
+	st.stats.pawn_probes++;
+	if(entry.key == key) {
+		st.stats.pawn_hits++;
+	} else {
+		evaluatePawns(board, entry);
+		entry.key = key;
+	}
+	return entry;
+}
+
+void BrutalPlayer::evaluatePawns(const Board & board, PawnTable::Entry & entry)
+{
+	entry.score = 0;
+	for(int c = 0; c <= Piece::LAST_COLOR; c++) {
+		Piece::Color color = Piece::Color(c);
+		unsigned long long own = board.m_color[color] & board.m_pieces[Piece::PAWN];
+		unsigned long long enemy = board.m_color[Piece::opposite(color)] & board.m_pieces[Piece::PAWN];
+		int sign = (color == Piece::WHITE) ? 1 : -1;
+
+		entry.passed[c] = entry.isolated[c] = entry.doubled[c] = 0;
+		for(unsigned long long pawns = own; pawns; pawns &= pawns - 1) {
+			int sq = bitScanForward(pawns);
+			int file = sq & 7, rank = sq >> 3;
+			unsigned long long bit = 1ULL << sq;
+
+			// The files either side of this one, and the ranks ahead
+			unsigned long long file_mask = FILE_A << file;
+			unsigned long long sides = 0;
+			if(file > 0) {
+				sides |= file_mask >> 1;
+			}
+			if(file < 7) {
+				sides |= file_mask << 1;
+			}
+			unsigned long long ahead = 0;
+			if(color == Piece::WHITE && rank < 7) {
+				ahead = ~0ULL << 8*(rank + 1);
+			} else if(color == Piece::BLACK && rank > 0) {
+				ahead = ~0ULL >> 8*(8 - rank);
+			}
+
+			if(!(enemy & (file_mask | sides) & ahead)) {
+				entry.passed[c] |= bit;
+				entry.score += sign*PASSED_BONUS[(color == Piece::WHITE) ? rank : 7 - rank];
+			}
+			if(!(own & sides)) {
+				entry.isolated[c] |= bit;
+				entry.score -= sign*ISOLATED_PENALTY[file];
+			}
+			if(own & file_mask & ~bit) {
+				entry.doubled[c] |= bit;
+				entry.score -= sign*DOUBLED_PENALTY;
+			}
+		}
 	}
+}
 
-	return true;
+int BrutalPlayer::queenBonus(const Board & board, Piece::Color c)
+{
+	int king = board.getKing(Piece::opposite(c)).hash();
+	int bonus = 0;
+
+	unsigned long long queens = board.m_pieces[Piece::QUEEN] & board.m_color[c];
+	for(; queens; queens &= queens - 1) {
+		int sq = bitScanForward(queens);
+		bonus -= 2*(abs((sq & 7) - (king & 7)) + abs((sq >> 3) - (king >> 3)));
+	}
+	return bonus;
 }
 
-bool BrutalPlayer::isDoubledPawn(const BoardPosition & bp, const Board & board)
+int BrutalPlayer::rookBonus(const Board & board, Piece::Color c)
 {
-	return false;
+	int bonus = 0;
+
+	// Rooks get a bonus of -4 points if blocked in, or up to 20 points if
+	// attacking 12 squares or more.
+	unsigned long long rooks = board.m_pieces[Piece::ROOK] & board.m_color[c];
+	for(; rooks; rooks &= rooks - 1) {
+		BoardPosition bp(bitScanForward(rooks));
+		unsigned long long attacks = Board::rankAttacks[bp.hash()][board.getRankState(bp)] |
+		                             Board::fileAttacks[bp.hash()][board.getFileState(bp)];
+		int attacked = popCount(attacks);
+		bonus += (attacked < 12) ? 2*attacked - 4 : 20;
+	}
+	return bonus;
 }
 
-// Positional Bonuses
-int BrutalPlayer::m_bishop[64] = {
-    -5,-5,-5,-5,-5,-5,-5,-5,
-    -5,10,5,10,10,5,10,-5,
-    -5,5,3,12,12,3,5,-5,
-    -5,3,12,3,3,12,3,-5,
-    -5,3,12,3,3,12,3,-5,
-    -5,5,3,12,12,3,5,-5,
-    -5,10,5,10,10,5,10,-5,
-    -5,-5,-5,-5,-5,-5,-5,-5 };
-
-int BrutalPlayer::m_knight[64] = {
-    -10,-5,-5,-5,-5,-5,-5,-10,
-    -5,0,0,3,3,0,0,-5,
-    -5,0,5,5,5,5,0,-5,
-    -5,0,5,10,10,5,0,-5,
-    -5,0,5,10,10,5,0,-5,
-    -5,0,5,5,5,5,0,-5,
-    -5,0,0,3,3,0,0,-5,
-    -10,-5,-5,-5,-5,-5,-5,-10 };
-
-int BrutalPlayer::m_wpawn[64] = {
-    0,0,0,0,0,0,0,0,
-    0,0,0,-5,-5,0,0,0,
-    1,2,3,4,4,3,2,1,
-    2,4,6,8,8,6,4,2,
-    3,6,9,12,12,9,6,3,
-    4,8,12,16,16,12,8,4,
-    5,10,15,20,20,15,10,5,
-    0,0,0,0,0,0,0,0 };
-
-int BrutalPlayer::m_bpawn[64] = {
-    0,0,0,0,0,0,0,0,
-    5,10,15,20,20,15,10,5,
-    4,8,12,16,16,12,8,4,
-    3,6,9,12,12,9,6,3,
-    2,4,6,8,8,6,4,2,
-    1,2,3,4,4,3,2,1,
-    0,0,0,-5,-5,0,0,0,
-    0,0,0,0,0,0,0,0 };
-
-int BrutalPlayer::m_wking[64] = {
-    2,10,4,0,0,7,10,2,
-    -3,-3,-5,-5,-5,-5,-3,-3,
-    -5,-5,-8,-8,-8,-8,-5,-5,
-    -8,-8,-13,-13,-13,-13,-8,-8,
-    -13,-13,-21,-21,-21,-21,-13,-13,
-    -21,-21,-34,-34,-34,-34,-21,-21,
-    -34,-34,-55,-55,-55,-55,-34,-34,
-    -55,-55,-89,-89,-89,-89,-55,-55};
-
-int BrutalPlayer::m_bking[64] = {
-    -55,-55,-89,-89,-89,-89,-55,-55,
-    -34,-34,-55,-55,-55,-55,-34,-34,
-    -21,-21,-34,-34,-34,-34,-21,-21,
-    -13,-13,-21,-21,-21,-21,-13,-13,
-    -8,-8,-13,-13,-13,-13,-8,-8,
-    -5,-5,-8,-8,-8,-8,-5,-5,
-    -3,-3,-5,-5,-5,-5,-3,-3,
-    2,10,4,0,0,7,10,2};
-
-int BrutalPlayer::m_end_king[64] = {
-    -5,-3,-1,0,0,-1,-3,-5,
-    -3,5,5,5,5,5,5,-3,
-    -1,5,10,10,10,10,5,-1,
-    0,5,10,15,15,10,5,0,
-    0,5,10,15,15,10,5,0,
-    -1,5,10,10,10,10,5,-1,
-    -3,5,5,5,5,5,5,-3,
-    -5,-3,-1,0,0,-1,-3,-5};
+// Kings are never captured, their value only matters as an attacker
+int BrutalPlayer::m_value[Piece::LAST_TYPE+1] = {100, 500, 310, 325, 900, 0};
 
 // end of file brutalplayer.cpp
 
@@ -8,6 +8,9 @@
 
 #include "chessgamestate.h"
 
+#include <cctype>
+#include <sstream>
+
 using namespace std;
 
 inline bool compareBoards(SerialBoard, SerialBoard);
@@ -19,6 +22,7 @@ void ChessGameState::reset()
     m_threefold = false;
 	m_turn_number = 1;
 	m_white_turn = true;
+	m_status = NORMAL;
 	m_last_move = BoardMove();
 	m_threefold_count.clear();
 	m_board.reset();
@@ -30,7 +34,6 @@ void ChessGameState::reset()
 			BoardPosition bp(file, rank);
 			
 			if(rank >= 3 && rank <= 6) {
-				m_pieces[bp.hash()] = NULL;
 				break;
 			} else if(rank == 2 || rank == 7) {
 				type = Piece::PAWN;
@@ -46,31 +49,201 @@ void ChessGameState::reset()
 				type = Piece::KING;
 			}
 
-			Piece* piece = new Piece(color, type);
-			m_pieces[bp.hash()] = piece;
-			m_board.addPiece(piece, bp);
+			// The board only takes the color and type, nothing to allocate
+			Piece piece(color, type);
+			m_board.addPiece(&piece, bp);
 		}
 	}
+
+	m_keys.clear();
+	m_keys.push_back(m_board.hashKey(Piece::WHITE));
 }
 
-bool ChessGameState::isDraw()
+bool ChessGameState::loadFEN(const string & fen)
 {
-    return  m_board.isStaleMate(this->getTurn()) ||
-            m_board.isMaterialDraw() ||
-            m_50_moves > 99 ||
-            m_threefold;
+	istringstream in(fen);
+	string placement, turn, castling, enpassant;
+	int halfmoves = 0, fullmoves = 1;
+
+	in >> placement >> turn >> castling >> enpassant;
+	if(!in || (turn != "w" && turn != "b")) {
+		return false;
+	}
+	// The move counters are often left off
+	if(!(in >> halfmoves >> fullmoves)) {
+		halfmoves = 0;
+		fullmoves = 1;
+	}
+
+	// Read the pieces first so a bad string leaves the state untouched
+	Piece::Type types[Board::BOARDSIZE*Board::BOARDSIZE];
+	Piece::Color colors[Board::BOARDSIZE*Board::BOARDSIZE];
+	for(int i = 0; i < Board::BOARDSIZE*Board::BOARDSIZE; i++) {
+		types[i] = Piece::NOTYPE;
+	}
+
+	// Ranks are listed from the 8th down, files from a to h
+	int rank = 8, wkings = 0, bkings = 0;
+	char file = 'a';
+	for(int i = 0; i < (int)placement.size(); i++) {
+		char c = placement[i];
+		if(c == '/') {
+			rank--;
+			file = 'a';
+			continue;
+		} else if(isdigit(c)) {
+			file += c - '0';
+			continue;
+		}
+
+		BoardPosition bp(file, rank);
+		if(!bp.isValid()) {
+			return false;
+		}
+
+		switch(tolower(c)) {
+			case 'p': types[bp.hash()] = Piece::PAWN; break;
+			case 'r': types[bp.hash()] = Piece::ROOK; break;
+			case 'n': types[bp.hash()] = Piece::KNIGHT; break;
+			case 'b': types[bp.hash()] = Piece::BISHOP; break;
+			case 'q': types[bp.hash()] = Piece::QUEEN; break;
+			case 'k':
+				types[bp.hash()] = Piece::KING;
+				if(isupper(c)) {
+					wkings++;
+				} else {
+					bkings++;
+				}
+				break;
+			default: return false;
+		}
+		colors[bp.hash()] = isupper(c) ? Piece::WHITE : Piece::BLACK;
+		file++;
+	}
+
+	if(rank != 1 || wkings != 1 || bkings != 1) {
+		return false;
+	}
+
+	BoardPosition epsquare;
+	if(enpassant != "-") {
+		if(enpassant.size() != 2) {
+			return false;
+		}
+		epsquare = BoardPosition(enpassant[0], enpassant[1] - '0');
+		if(!epsquare.isValid()) {
+			return false;
+		}
+	}
+
+	Board board;
+	for(int i = 0; i < Board::BOARDSIZE*Board::BOARDSIZE; i++) {
+		if(types[i] != Piece::NOTYPE) {
+			Piece piece(colors[i], types[i]);
+			board.addPiece(&piece, BoardPosition(i));
+		}
+	}
+
+	board.setCastlingRights(castling.find('K') != string::npos,
+	                        castling.find('Q') != string::npos,
+	                        castling.find('k') != string::npos,
+	                        castling.find('q') != string::npos);
+	if(epsquare.isValid()) {
+		board.setEnPassant(epsquare);
+	}
+
+	m_board = board;
+	m_white_turn = (turn == "w");
+	m_50_moves = halfmoves;
+	m_turn_number = fullmoves;
+	m_last_move = BoardMove();
+	m_check = m_board.isCheck(getTurn());
+	m_threefold = false;
+	m_threefold_count.clear();
+	m_keys.clear();
+	m_keys.push_back(m_board.hashKey(getTurn()));
+
+	SerialBoard sb = m_board.serialize();
+	sb.white_turn = m_white_turn ? 1 : 0;
+	m_threefold_count.push_back(make_pair(sb, 1));
+	updateStatus();
+
+	return true;
+}
+
+string ChessGameState::toFEN() const
+{
+	static const char LETTERS[] = "prnbqk";
+	ostringstream out;
+
+	for(int rank = 8; rank >= 1; rank--) {
+		int empty = 0;
+		for(char file = 'a'; file <= 'h'; file++) {
+			Piece * piece = m_board.getPiece(BoardPosition(file, rank));
+			if(!piece) {
+				empty++;
+				continue;
+			}
+			if(empty) {
+				out << empty;
+				empty = 0;
+			}
+			char c = LETTERS[piece->type()];
+			out << (char)(piece->color() == Piece::WHITE ? toupper(c) : c);
+		}
+		if(empty) {
+			out << empty;
+		}
+		if(rank > 1) {
+			out << '/';
+		}
+	}
+
+	out << (m_white_turn ? " w " : " b ");
+	string castling;
+	if(m_board.canCastle(Piece::WHITE, true)) castling += 'K';
+	if(m_board.canCastle(Piece::WHITE, false)) castling += 'Q';
+	if(m_board.canCastle(Piece::BLACK, true)) castling += 'k';
+	if(m_board.canCastle(Piece::BLACK, false)) castling += 'q';
+	out << (castling.empty() ? "-" : castling);
+
+	// Only the square the side to move could capture on counts
+	string enpassant = "-";
+	int rank = m_white_turn ? 6 : 3;
+	for(char file = 'a'; file <= 'h'; file++) {
+		if(m_board.isEnPassantSet(BoardPosition(file, rank))) {
+			ostringstream square;
+			square << BoardPosition(file, rank);
+			enpassant = square.str();
+		}
+	}
+	out << " " << enpassant << " " << m_50_moves << " " << m_turn_number;
+	return out.str();
 }
 
-// Change this function to return enum about the state of the board
-// i.e. check, checkmate, move out of check,stalemate draw, 50 move draw, 
-// normal, etc... used by chessgame to push user events 
-// onto the stack to handle the various animations and endgame scenarios.
-void ChessGameState::update(const BoardMove& bm)
+void ChessGameState::updateStatus()
+{
+	// A single legal move rules out both mate and stalemate, and a mate
+	// stands even on the move that would have drawn
+	if(m_board.possibleMoves(getTurn(), true).empty()) {
+		m_status = m_check ? CHECKMATE : STALEMATE;
+	} else if(m_board.isMaterialDraw()) {
+		m_status = MATERIAL_DRAW;
+	} else if(m_50_moves >= 100) {
+		m_status = FIFTY_MOVE_DRAW;
+	} else if(m_threefold) {
+		m_status = THREEFOLD_DRAW;
+	} else {
+		m_status = m_check ? CHECK : NORMAL;
+	}
+}
+
+ChessGameState::Status ChessGameState::update(const BoardMove& bm)
 {
 	SerialBoard sb;
 	
 	if(m_turn_number > 1 && m_last_move.needPromotion()) {
-		return;
+		return m_status;
 	}
 
 	// Handle the start of a game
@@ -80,47 +253,23 @@ void ChessGameState::update(const BoardMove& bm)
 		m_threefold_count.push_back(make_pair(sb, 1));
 	}
 
-	if(m_board.getPiece(bm.origin())->type() != Piece::PAWN ||
+	// Pawn moves and captures can't be undone, so they restart the count
+	// to 50 and no position before them can come up again
+	if(m_board.getPiece(bm.origin())->type() == Piece::PAWN ||
 	   m_board.isOccupied(bm.dest())) {
-		m_50_moves++;
-	} else {
 		m_50_moves = 0;
 		m_threefold_count.clear();
+		m_keys.clear();
+	} else {
+		m_50_moves++;
 	}
 
 	m_board.update(bm);
 	m_last_move = bm;
 	m_white_turn = !m_white_turn;
 
-	Piece::Color color = bm.getPiece()->color();
-	Piece::Type type = bm.getPiece()->type();
-
-	if(type == Piece::PAWN && bm.fileDiff() == bm.rankDiff() && !m_pieces[bm.dest().hash()]) {
-		// EnPassant capture
-		if(color == Piece::WHITE) {
-			m_pieces[bm.dest().S().hash()] = NULL;
-		} else {
-			m_pieces[bm.dest().N().hash()] = NULL;
-		}
-	} else if(type == Piece::KING && bm.signedFileDiff() == -2) {
-		// Castling to the left
-		BoardPosition corner = (color == Piece::WHITE) ?
-			BoardPosition('a',1) : BoardPosition('a',8);
-		m_pieces[bm.origin().W().hash()] = m_pieces[corner.hash()];
-		m_pieces[corner.hash()] = NULL;
-	} else if(type == Piece::KING && bm.signedFileDiff() == 2) {
-		// Castling to the right
-		BoardPosition corner = (color == Piece::WHITE) ?
-			BoardPosition('h',1) : BoardPosition('h',8);
-		m_pieces[bm.origin().E().hash()] = m_pieces[corner.hash()];
-		m_pieces[corner.hash()] = NULL;
-	}
-	
-	m_pieces[bm.dest().hash()] = m_pieces[bm.origin().hash()];
-	m_pieces[bm.dest().hash()]->promotePawn(bm.getPromotion());
-	m_pieces[bm.origin().hash()] = NULL;
-	
 	m_check = m_board.isCheck(getTurn());
+	m_keys.push_back(m_board.hashKey(getTurn()));
 
 	// Update the threefold repetiiton counter
 	int i = 0;
@@ -146,6 +295,9 @@ void ChessGameState::update(const BoardMove& bm)
 	if(m_white_turn) {
 		m_turn_number++;
 	}
+
+	updateStatus();
+	return m_status;
 }
 
 bool ChessGameState::isPositionSelectable(const BoardPosition& bp) const
@@ -11,6 +11,7 @@
 
 #include <map>
 #include <stack>
+#include <string>
 #include <vector>
 
 #include "board.h"
@@ -21,6 +22,13 @@ class ChessGameState {
 
   public:
 
+	/**
+	 * Where the game stands for the player to move. Everything from
+	 * CHECKMATE on ends the game.
+	 */
+	enum Status { NORMAL, CHECK, CHECKMATE, STALEMATE, FIFTY_MOVE_DRAW,
+	              THREEFOLD_DRAW, MATERIAL_DRAW };
+
 	/** Default constructor for ChessGameState */
 	ChessGameState()
 		{ reset(); }
@@ -28,18 +36,41 @@ class ChessGameState {
 	/** Reset to the beginning ChessGameState */
 	void reset();
 
+	/**
+	 * Set up the position described by a FEN string. Returns false, leaving
+	 * the state untouched, if the string can't be parsed.
+	 * @param fen - The position in Forsyth-Edwards Notation.
+	 */
+	bool loadFEN(const std::string & fen);
+
+	/** Returns the position in Forsyth-Edwards Notation, as loadFEN reads it. */
+	std::string toFEN() const;
+
 	/** 
-	 * Update ChessGameState to reflect current state of the game
+	 * Update ChessGameState to reflect current state of the game, and
+	 * return the status it leaves the game in.
 	 * @param - bm - The legal BoardMove for updating the game.
 	 */
-	void update(const BoardMove& bm);
+	Status update(const BoardMove& bm);
 
 	/** Returns true if the current player is in check */
 	bool isCheck() const
 		{ return m_check; }
 
+	/**
+	 * Returns the status of the game, worked out once per move so asking
+	 * costs nothing.
+	 */
+	Status getStatus() const
+		{ return m_status; }
+
+	/** Returns true if the game has ended, won or drawn */
+	bool isGameOver() const
+		{ return m_status >= CHECKMATE; }
+
 	/** Returns true if the game is a draw*/
-	bool isDraw();
+	bool isDraw() const
+		{ return m_status >= STALEMATE; }
 
 	/** Returns true if it is white's turn, false otherwise */
 	bool isWhiteTurn() const
@@ -67,17 +98,33 @@ class ChessGameState {
 	/** Returns the number of turns played so far */
 	int getTurnNumber() const
 		{ return m_turn_number; }
+
+	/** Returns the number of moves since the last capture or pawn move */
+	int getFiftyMoveCount() const
+		{ return m_50_moves; }
+
+	/**
+	 * Returns the hash keys of the positions since the last capture or
+	 * pawn move, oldest first and ending with the current one, which are
+	 * all the positions that could still be repeated.
+	 */
+	const std::vector<unsigned long long> & getKeyHistory() const
+		{ return m_keys; }
 	
     friend class ChessGame;
 
   private:
 
+	/** Works out m_status from the board and the draw counters. */
+	void updateStatus();
+
     std::vector<std::pair<SerialBoard, int> > m_threefold_count;
-	Piece* m_pieces[Board::BOARDSIZE*Board::BOARDSIZE];
+	std::vector<unsigned long long> m_keys;
 	Board m_board;
 	BoardMove m_last_move;
 	bool m_white_turn, m_check, m_threefold;
 	int m_turn_number, m_50_moves;
+	Status m_status;
 };
 
 #endif
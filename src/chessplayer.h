@@ -11,13 +11,14 @@
 
 #include "boardmove.h"
 #include "chessgamestate.h"
+#include "searchstats.h"
 
 #include <string>
 
 class ChessPlayer {
  public:
 	 
-	ChessPlayer() : m_is_thinking(false), m_is_human(false) {}
+	ChessPlayer() : m_is_thinking(false), m_is_human(false), m_interrupted(false) {}
 
 	virtual ~ChessPlayer() {}
 
@@ -40,8 +41,30 @@ class ChessPlayer {
 	virtual BoardMove getMove()
 		{ return m_move; }
 	
+	/**
+	 * Asks a think in progress, possibly on another thread, to return as
+	 * soon as it can. Players that search leave the best move found so
+	 * far, others give up without one.
+	 */
 	virtual void interruptThinking()
-		{ m_is_thinking = false; }		
+		{ m_interrupted = true; m_is_thinking = false; }
+
+	/** Returns true if the last think was cut short by interruptThinking. */
+	bool wasInterrupted() const
+		{ return m_interrupted; }
+
+	/** Clears an old interrupt, must be called before starting a think. */
+	void resetInterrupt()
+		{ m_interrupted = false; }
+
+	/**
+	 * Tells the player the time left on its clock and the time it gets
+	 * back after each move, both in ms. It is called before each move the
+	 * player is asked for, before the opponent's move is passed on, so
+	 * engines that think straight away have it in time. Players that don't
+	 * play to a clock ignore it.
+	 */
+	virtual void setClock(unsigned int remaining, unsigned int increment) {}
 
 	virtual bool needMove()
 		{ return false; }
@@ -62,13 +85,24 @@ class ChessPlayer {
 	Piece::Color getColor() const
 		{ return (m_is_white ? Piece::WHITE : Piece::BLACK); }
 
+	/**
+	 * Returns the statistics of the last think, all zero for players
+	 * that don't search.
+	 */
+	virtual const SearchStats & getSearchStats() const
+		{ return m_stats; }
+
  protected:
 
 	bool m_is_white;
-	bool m_is_thinking;
+	volatile bool m_is_thinking;
 	bool m_is_human;	
 	bool m_trustworthy;
 	BoardMove m_move;
+	SearchStats m_stats;
+
+	// Set from other threads, think implementations poll it
+	volatile bool m_interrupted;
 };
 
 ChessPlayer * PlayerFactory(const std::string & playertype);
@@ -8,10 +8,24 @@
 
 #ifdef INCHESSPLAYER_H
 
+#include "network.h"
+#include "options.h"
+#include "pawntable.h"
+#include "SDL_thread.h"
+
+#include <algorithm>
 #include <vector>
 
+#ifndef WIN32
+#include <sys/types.h>
+#endif
+
 using std::vector;
 
+class EndgameTables;
+class MateSearch;
+class TranspositionTable;
+
 class HumanPlayer : public ChessPlayer {
  public:
 	HumanPlayer();
@@ -37,36 +51,465 @@ class HumanPlayer : public ChessPlayer {
 class BrutalPlayer : public ChessPlayer {
  public:
 	BrutalPlayer();
+
+	~BrutalPlayer();
+
 	void think(const ChessGameState & cgs);
 
+	/** Drops any pondering left over from the last game. */
+	void newGame();
+
+	/**
+	 * Checks the opponent's move against the reply being pondered and
+	 * abandons the ponder search if they played something else.
+	 */
+	void opponentMove(const BoardMove & move, const ChessGameState & cgs);
+
+	void undoMove();
+
+	/** Stops the search, think returns with the best move found so far. */
+	void interruptThinking();
+
 	int getPly() { return m_ply; }
 	void setPly(int ply) { m_ply = ply; }
 
+	/**
+	 * Sets the number of threads used to search. Any beyond the first are
+	 * Lazy SMP helpers sharing the transposition table.
+	 */
+	void setThreads(int threads) { m_threads = (threads < 1) ? 1 : threads; }
+
+	int getThreads() const { return m_threads; }
+
+	/**
+	 * Limits each think to the given number of milliseconds on top of the
+	 * ply limit, 0 for no time limit.
+	 */
+	void setMoveTime(Uint32 ms) { m_movetime = ms; }
+
+	Uint32 getMoveTime() const { return m_movetime; }
+
+	/**
+	 * Sets the time limit of the next think from the time left on the
+	 * clock, as if the game will last another MOVES_TO_GO moves.
+	 */
+	void setClock(unsigned int remaining, unsigned int increment);
+
+	/** Moves a clock is expected to last for when budgeting a think */
+	static const int MOVES_TO_GO = 30;
+
+	/**
+	 * Limits each think to about the given number of nodes of the main
+	 * search thread, and the mate search to no more, 0 for no limit.
+	 */
+	void setMaxNodes(unsigned long nodes);
+
+	unsigned long getMaxNodes() const { return m_maxnodes; }
+
+	/**
+	 * Adds an error of up to the given number of centipawns to every
+	 * evaluation, to weaken the player. A position gets the same error
+	 * each time it is evaluated during a game, so searches stay consistent.
+	 */
+	void setEvalNoise(int centipawns) { m_noise = (centipawns < 0) ? 0 : centipawns; }
+
+	/**
+	 * Plays at the node, time and noise budgets of level in the Options,
+	 * searching as deep as they allow. The time budget bounds every think.
+	 */
+	void setDifficulty(Difficulty level);
+
+	/** Resizes the transposition table, clearing it. */
+	void setHashSize(int megabytes);
+
+	/** Deepest search, in plies, any thread will attempt. */
+	static const int MAX_DEPTH = 64;
+
+	/** Deepest ply a search can reach, including quiescence. */
+	static const int MAX_PLY = 128;
+
+	/**
+	 * Most positions from before the root a search looks back on for
+	 * repetitions. The game is drawn by the fifty move rule before more
+	 * could count.
+	 */
+	static const int MAX_GAME_KEYS = 100;
+
+	/** Turns null move pruning on or off. */
+	void setNullMovePruning(bool on) { m_nullmove = on; }
+
+	/** Turns late move reductions of quiet moves on or off. */
+	void setLateMoveReductions(bool on) { m_lmr = on; }
+
+	/** Turns futility pruning at frontier nodes on or off. */
+	void setFutilityPruning(bool on) { m_futility = on; }
+
+	/** Turns razoring at pre-frontier nodes on or off. */
+	void setRazoring(bool on) { m_razoring = on; }
+
+	/**
+	 * Turns pondering on or off. While pondering the player searches the
+	 * reply it expects from the opponent on a single background thread
+	 * between its own moves.
+	 */
+	void setPondering(bool on) { m_ponder = on; if(!on) stopPondering(); }
+
+	bool isPondering() const { return m_ponderthread != NULL; }
+
+	/**
+	 * Starts analysing the game's position on a background thread, to
+	 * give a human player hints. It takes the place of any pondering and
+	 * shares this player's table, so the work helps our own next search
+	 * whatever the reply. It stops when the position changes.
+	 */
+	void startAnalysis(const ChessGameState & cgs);
+
+	/**
+	 * Gets the best move the analysis of board has found so far, with its
+	 * score for the side to move and the depth it was found at. Returns
+	 * false if board isn't being analysed or no iteration has finished.
+	 */
+	bool getAnalysis(const Board & board, Piece::Color color, BoardMove & move,
+	                 int & score, int & depth) const;
+
+	/** Stops the analysis, if any, leaving pondering alone. */
+	void stopAnalysis() { if(m_analysing) stopPondering(); }
+
+	/**
+	 * Turns the opening book on or off. With it on, positions found in the
+	 * book are answered with a book move instead of a search.
+	 */
+	void setUseBook(bool on) { m_usebook = on; }
+
+	/**
+	 * Turns the endgame tables on or off. With them on, positions in the
+	 * tables are played perfectly and scored without searching.
+	 */
+	void setUseTablebases(bool on) { m_usetables = on; }
+
+	/**
+	 * Looks for a forced mate in up to the given number of moves before
+	 * searching, and plays it if there is one. 0 turns it off.
+	 */
+	void setMateSearch(int moves) { m_matemoves = moves; }
+
+	/**
+	 * Turns the neural network evaluation on or off. It is only used if
+	 * its weights were loaded, the hand-written evaluation is used if not.
+	 */
+	void setUseNetwork(bool on) { m_usenetwork = on; }
+
+	/** One of the best root moves, with the line expected to follow it. */
+	struct Line {
+		/** Score for the side to move */
+		int score;
+
+		/** Depth the line was searched to */
+		int depth;
+
+		/** The root move followed by the expected replies */
+		vector<BoardMove> pv;
+	};
+
+	/**
+	 * Sets how many of the best root moves each think reports, for analysis
+	 * and hints. All the lines come out of one search sharing one table,
+	 * only moves good enough to make the list are searched for an exact
+	 * score, so K lines cost far less than K searches.
+	 */
+	void setMultiPV(int lines) { m_multipv = (lines < 1) ? 1 : lines; }
+
+	int getMultiPV() const { return m_multipv; }
+
+	/**
+	 * Returns the lines found by the last think, best first. Empty when the
+	 * move came from the book, the endgame tables or the mate search.
+	 */
+	const vector<Line> & getLines() const { return m_lines; }
+
+	/**
+	 * Scores n boards into out at once, for scoring large sets of
+	 * positions offline, with the same evaluation the search would use.
+	 * Each score is for the side to move given in turns, or for white if
+	 * turns is 0. Not to be called while thinking.
+	 */
+	void evaluateBatch(const Board * boards, int n, int * out, const Piece::Color * turns = 0);
+
+#ifndef NDEBUG
+	/**
+	 * Writes out each term of the static evaluation of board, for both
+	 * sides and from the side to move's point of view, to track down
+	 * evaluation bugs. Only in debug builds.
+	 */
+	void printEvaluation(std::ostream & out, const Board & board, Piece::Color turn);
+#endif
+
  protected:
-	int evaluateBoard(const Board & board, Piece::Color color);
-	int search(Board board, Piece::Color color, int depth, int alpha, int beta, BoardMove& move);
-	int pawnBonus(const BoardPosition & bp, const Board & board, Piece::Color turn, bool endgame);
-	int knightBonus(const BoardPosition & bp, const Board & board, Piece::Color turn, bool endgame);
-	int bishopBonus(const BoardPosition & bp, const Board & board, Piece::Color turn, bool endgame);
-	int rookBonus(const BoardPosition & bp, const Board & board, Piece::Color turn, bool endgame);
-	int queenBonus(const BoardPosition & bp, const Board & board, Piece::Color turn, bool endgame);
-	int kingBonus(const BoardPosition & bp, const Board & board, Piece::Color turn, bool endgame);
-
-	int numAttackedSquares(const unsigned long long & pieceAttacks);
-
-	bool isIsolatedPawn(const BoardPosition & bp, const Board & board);
-	bool isDoubledPawn(const BoardPosition & bp, const Board & board);
-   
-	// Used to calculate positional bonuses
-	static int m_bishop[64];
-	static int m_knight[64];
-	static int m_wpawn[64];
-	static int m_bpawn[64];
-	static int m_wking[64];
-	static int m_bking[64];
-	static int m_end_king[64];
+	/**
+	 * State owned by each thread taking part in a search. Everything the
+	 * search needs per ply is allocated up front, so searching never
+	 * touches the heap.
+	 */
+	struct SearchThread {
+		SearchThread()
+		{
+			int * h = &history[0][0][0];
+			for(int i = 0; i < 2*64*64; i++) {
+				h[i] = 0;
+			}
+			for(int ply = 0; ply <= MAX_PLY; ply++) {
+				accumulators[ply].key = 0;
+			}
+		}
+
+		/**
+		 * Readies the thread to search board with color to move. The game
+		 * keys are those of the positions before board since the last
+		 * capture or pawn move, halfmoves the count of moves since it. The
+		 * history carries over from the last search, at half weight.
+		 */
+		void prepare(BrutalPlayer * p, int i, const Board & board, Piece::Color c,
+		             const vector<unsigned long long> & game, int halfmoves)
+		{
+			player = p;
+			id = i;
+			color = c;
+			stack[0] = board;
+			gamekeys = std::min((int)game.size(), MAX_GAME_KEYS);
+			for(int k = 0; k < gamekeys; k++) {
+				keys[k] = game[game.size() - gamekeys + k];
+			}
+			fifty[0] = halfmoves;
+			stats.reset();
+			multipv = 1;
+			lines.clear();
+			for(int ply = 0; ply < MAX_PLY; ply++) {
+				killers[ply][0] = killers[ply][1] = 0;
+			}
+			ageHistory();
+		}
+
+		/** Halves every history score. */
+		void ageHistory()
+		{
+			int * h = &history[0][0][0];
+			for(int i = 0; i < 2*64*64; i++) {
+				h[i] /= 2;
+			}
+		}
+
+		BrutalPlayer * player;
+		int id;
+		Piece::Color color;
+		SearchStats stats;
+
+		// Position at each ply, made by copying the one below and playing
+		// a move on it
+		Board stack[MAX_PLY + 1];
+
+		// Keys of the game's positions before the root, then of the position
+		// at each ply of the search from keys[gamekeys] on
+		unsigned long long keys[MAX_GAME_KEYS + MAX_PLY + 1];
+		int gamekeys;
+
+		// Moves since the last capture or pawn move at each ply, restarted
+		// by a null move since a pass can't make a real repetition
+		int fifty[MAX_PLY + 1];
+
+		// Move list and ordering scores at each ply
+		BoardMove moves[MAX_PLY][Board::MAX_MOVES];
+		int scores[MAX_PLY][Board::MAX_MOVES];
+
+		// Triangular table of principal variations, pv[ply] is the best
+		// line found from that ply on
+		BoardMove pv[MAX_PLY][MAX_PLY];
+		int pvlength[MAX_PLY];
+
+		// Two most recent quiet moves to cause a cutoff at each ply, packed
+		int killers[MAX_PLY][2];
+
+		// How often each quiet move, by color, origin and destination, has
+		// caused a cutoff, weighted by the depth it did so at
+		int history[2][64][64];
+
+		// Pawn structures this thread has evaluated
+		PawnTable pawns;
+
+		// Neural network sums of the position at each ply, only worked out
+		// when it is evaluated and only valid while their key matches it
+		Network::Accumulator accumulators[MAX_PLY + 1];
+
+		// Best root moves of the current iteration, best first, and how many
+		// are wanted. Only the main thread searches more than one.
+		int multipv;
+		vector<Line> lines;
+	};
+
+	/**
+	 * Returns true once the search should unwind. The clock and interrupt
+	 * are only looked at every few thousand nodes, m_stop is cheap enough
+	 * to read at every node.
+	 */
+	bool isStopped(SearchThread & st);
+
+	/** Entry point for the Lazy SMP helper threads. */
+	static int helperThread(void * data);
+
+	/**
+	 * Guesses the opponent's reply to move from the transposition table
+	 * and starts searching the position it leads to.
+	 */
+	void startPondering(const Board & board, const BoardMove & move);
+
+	/**
+	 * Picks the move the endgame tables say is best: the quickest mate when
+	 * winning, a draw if there is one, else the slowest loss. Returns an
+	 * invalid move if the tables don't cover the position.
+	 */
+	BoardMove tablebaseMove(const Board & board);
+
+	/** Stops the ponder search, if any, and waits for it to finish. */
+	void stopPondering();
+
+	/** Entry point for the ponder thread. */
+	static int ponderThread(void * data);
+
+	/**
+	 * Returns the static score of st.stack[ply] for color, from the neural
+	 * network if it is in use and evaluateBoard if not.
+	 */
+	int evaluate(SearchThread & st, int ply, Piece::Color color);
+
+	/**
+	 * Returns the network's score of st.stack[ply], bringing the sums up
+	 * to date from the nearest ply below that has them.
+	 */
+	int evaluateNetwork(SearchThread & st, int ply, Piece::Color color);
+
+	int evaluateBoard(SearchThread & st, const Board & board, Piece::Color color);
+
+	/** Returns the evaluation error of board for color, see setEvalNoise. */
+	int evalNoise(const Board & board, Piece::Color color) const;
+
+	/**
+	 * Returns the pawn structure of board from st's pawn table, working it
+	 * out and storing it first if it isn't there.
+	 */
+	const PawnTable::Entry & probePawns(SearchThread & st, const Board & board);
+
+	/** Works out the score and pawn bitboards of board's pawn structure. */
+	void evaluatePawns(const Board & board, PawnTable::Entry & entry);
+
+	/**
+	 * Returns true if st.stack[ply], whose key is st.keys[st.gamekeys+ply],
+	 * is drawn by the fifty move rule or repeats a position since the last
+	 * capture or pawn move, in the game or along the search path. A single
+	 * repetition is scored as a draw, playing on from it leads nowhere the
+	 * first visit didn't.
+	 */
+	bool isRepetition(const SearchThread & st, int ply) const;
+
+	/**
+	 * Searches st.stack[ply] with color to move. The best line found is
+	 * left in st.pv[ply].
+	 */
+	int search(SearchThread & st, Piece::Color color, int depth, int ply, int alpha, int beta, bool allownull = true);
+	int quiesce(SearchThread & st, Piece::Color color, int ply, int alpha, int beta);
+
+	/**
+	 * Puts the principal variation of the last think back in the table,
+	 * where later searches may have overwritten it.
+	 */
+	void restorePV();
+
+	/** Makes move followed by the line from ply+1 the line at ply. */
+	void updatePV(SearchThread & st, int ply, const BoardMove & move);
+
+	/**
+	 * Puts the root move followed by the line from ply 1 into st.lines,
+	 * dropping the worst line if there are more than wanted.
+	 */
+	void addLine(SearchThread & st, const BoardMove & move, int score, int depth);
+
+	/**
+	 * Sorts the moves at ply so the hash move comes first, then captures
+	 * with the most valuable victim and least valuable attacker leading,
+	 * then killers, then the other quiet moves.
+	 */
+	void orderMoves(SearchThread & st, int ply, int count, int hashmove);
+	bool isCapture(const Board & board, const BoardMove & bm);
+
+	/** Bonus for c's queens closing in on the enemy king, an endgame term. */
+	int queenBonus(const Board & board, Piece::Color c);
+
+	/** Bonus for c's rooks by the number of squares they reach. */
+	int rookBonus(const Board & board, Piece::Color c);
+
+	// Material values used for move ordering and pruning margins
+	static int m_value[Piece::LAST_TYPE+1];
 
 	int m_ply;
+	int m_threads;
+
+	// Lines wanted from each think, and those the last one found
+	int m_multipv;
+	vector<Line> m_lines;
+
+	// Keys of the positions before the one the last think was for since
+	// the last capture or pawn move, and the count of moves since it
+	vector<unsigned long long> m_gamekeys;
+	int m_fifty;
+
+	// Principal variation of the last think as packed moves, and the
+	// position it starts from
+	vector<int> m_pv;
+	Board m_pvboard;
+	Piece::Color m_pvcolor;
+
+	// Time allowed per move and when the current think must finish, 0 if
+	// there is no limit
+	Uint32 m_movetime;
+	volatile Uint32 m_deadline;
+
+	// Nodes allowed per move and the limit of the current think, 0 if
+	// there is none
+	unsigned long m_maxnodes;
+	volatile unsigned long m_nodelimit;
+
+	// Most evaluation error, and the random number mixed into the key of
+	// each position to pick its error, new each game
+	int m_noise;
+	unsigned long long m_noiseseed;
+
+	bool m_nullmove, m_lmr, m_futility, m_razoring, m_usebook, m_usetables, m_usenetwork;
+
+	TranspositionTable * m_tt;
+
+	// Shared by every player, not owned
+	EndgameTables * m_tables;
+	Network * m_network;
+
+	// Mate finder run before the search, and the longest mate it looks for
+	MateSearch * m_matesearch;
+	int m_matemoves;
+
+	// One per search thread, the first is the main thread
+	vector<SearchThread*> m_searchers;
+
+	// Pondering state. The ponder thread owns m_ponderer and writes the
+	// move, score and depth of each iteration it completes. Analysis for
+	// hints runs on the same thread, with m_analysing set.
+	bool m_ponder;
+	SDL_Thread * m_ponderthread;
+	SearchThread * m_ponderer;
+	unsigned long long m_ponder_key;
+	volatile int m_ponder_move;
+	volatile int m_ponder_score;
+	volatile int m_ponder_depth;
+	bool m_analysing;
+
+	// Tells the helper threads to finish up
+	volatile bool m_stop;
 };
 
 class RandomPlayer : public ChessPlayer {
@@ -101,7 +544,7 @@ class XboardPlayer : public ChessPlayer {
 
 	/**
 	 * Load a saved game ofchess into the XboardPlayer. This function
-	 * starts the gnuchess process using the saved game.
+	 * starts the gnuchess process and sets the game's position up.
 	 */
 	void loadGame(const ChessGameState& cgs);
 
@@ -121,6 +564,9 @@ class XboardPlayer : public ChessPlayer {
 	void opponentMove(const BoardMove & move, const ChessGameState & cgs);
 
 	void undoMove();
+
+	/** Sends the engine its level the first time, then its clock. */
+	void setClock(unsigned int remaining, unsigned int increment);
 	
  private:
 	// Starts GnuChess
@@ -128,7 +574,14 @@ class XboardPlayer : public ChessPlayer {
 	
 	int m_to[2];
 	int m_from[2];
+	pid_t m_pid;
 	bool m_initialized;
+
+	// Whose turn it is, and whether the engine was put in force mode to
+	// set a position up and has to be told to go when its turn comes
+	Piece::Color m_turn;
+	bool m_forced;
+	bool m_level;
 };
 
 /**
@@ -149,7 +602,7 @@ class FailePlayer : public ChessPlayer {
 
 	/**
 	 * Load a saved game ofchess into the FailePlayer. This function
-	 * starts the gnuchess process using the saved game.
+	 * starts the faile process and sets the game's position up.
 	 */
 	void loadGame(const ChessGameState& cgs);
 
@@ -169,6 +622,9 @@ class FailePlayer : public ChessPlayer {
 	void opponentMove(const BoardMove & move, const ChessGameState & cgs);
 
 	void undoMove();
+
+	/** Sends the engine its level the first time, then its clock. */
+	void setClock(unsigned int remaining, unsigned int increment);
 	
  private:
 	// Starts Faile
@@ -176,7 +632,14 @@ class FailePlayer : public ChessPlayer {
 	
 	int m_to[2];
 	int m_from[2];
+	pid_t m_pid;
 	bool m_initialized;
+
+	// Whose turn it is, and whether the engine was put in force mode to
+	// set a position up and has to be told to go when its turn comes
+	Piece::Color m_turn;
+	bool m_forced;
+	bool m_level;
 };
 
 #endif // #ifndef WIN32
@@ -0,0 +1,395 @@
+/***************************************************************************
+ * Brutal Chess
+ * http://brutalchess.sf.net
+ *
+ * File : egtb.cpp
+ * Authors : Mike Cook, Joe Flint, Neil Pankey
+ **************************************************************************/
+
+#include "egtb.h"
+#include "options.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+using namespace std;
+
+static const char EGTB_MAGIC[4] = { 'B', 'C', 'T', 'B' };
+static const int EGTB_VERSION = 1;
+
+// Pieces other than the king in the order they're listed in table names
+static const Piece::Type TABLE_ORDER[] = {
+	Piece::QUEEN, Piece::ROOK, Piece::BISHOP, Piece::KNIGHT, Piece::PAWN
+};
+static const int NUM_TABLE_PIECES = sizeof(TABLE_ORDER) / sizeof(TABLE_ORDER[0]);
+static const char TABLE_LETTERS[] = "QRBNP";
+
+// Rough material values for deciding which side is the stronger
+static const int TABLE_VALUES[] = { 9, 5, 3, 3, 1 };
+
+static Piece::Type letterType(char letter)
+{
+	if(letter == 'K') {
+		return Piece::KING;
+	}
+	const char * found = strchr(TABLE_LETTERS, letter);
+	return found ? TABLE_ORDER[found - TABLE_LETTERS] : Piece::NOTYPE;
+}
+
+static int materialValue(const string & side)
+{
+	int value = 0;
+	for(string::size_type i = 0; i < side.size(); i++) {
+		const char * found = strchr(TABLE_LETTERS, side[i]);
+		if(found) {
+			value += TABLE_VALUES[found - TABLE_LETTERS];
+		}
+	}
+	return value;
+}
+
+// True if side a is stronger than side b. Equal material is broken by the
+// most valuable piece so every pairing has one name.
+static bool isStronger(const string & a, const string & b)
+{
+	int va = materialValue(a), vb = materialValue(b);
+	if(va != vb) {
+		return va > vb;
+	}
+	for(string::size_type i = 0; i < a.size() && i < b.size(); i++) {
+		if(a[i] != b[i]) {
+			return strchr(TABLE_LETTERS, a[i]) < strchr(TABLE_LETTERS, b[i]);
+		}
+	}
+	return a.size() > b.size();
+}
+
+static int countPawns(const string & name)
+{
+	return (int)count(name.begin(), name.end(), 'P');
+}
+
+static bool smallerTable(const string & a, const string & b)
+{
+	if(a.size() != b.size()) {
+		return a.size() < b.size();
+	}
+	return countPawns(a) < countPawns(b);
+}
+
+void EndgamePosition::set(const Board & board, Piece::Color c)
+{
+	count = 0;
+	turn = c;
+	for(int col = 0; col <= Piece::LAST_COLOR; col++) {
+		for(int t = 0; t <= Piece::LAST_TYPE; t++) {
+			unsigned long long men = board.getPieces(Piece::Color(col), Piece::Type(t)).getBoard();
+			for(; men && count < EGTB_MAX_MEN; men &= men - 1) {
+				color[count] = Piece::Color(col);
+				type[count] = Piece::Type(t);
+				square[count] = bitScanForward(men);
+				count++;
+			}
+		}
+	}
+}
+
+EndgameTable::EndgameTable(const string & name) :
+	m_name(name),
+	m_men(0),
+	m_pawns(false),
+	m_bits(0)
+{
+	Piece::Color side = Piece::BLACK;
+	for(string::size_type i = 0; i < name.size() && m_men < EGTB_MAX_MEN; i++) {
+		Piece::Type t = letterType(name[i]);
+		if(t == Piece::KING) {
+			side = (m_men == 0) ? Piece::WHITE : Piece::BLACK;
+		}
+		m_color[m_men] = side;
+		m_type[m_men] = t;
+		m_pawns = m_pawns || t == Piece::PAWN;
+		m_men++;
+	}
+
+	m_kingsquares = m_pawns ? 32 : 16;
+	m_size = 2 * m_kingsquares;
+	for(int i = 1; i < m_men; i++) {
+		m_size *= 64;
+	}
+}
+
+size_t EndgameTable::index(const int * squares, Piece::Color turn) const
+{
+	// Mirror the board so the white king lands in the part that's kept
+	int mirror = 0;
+	if((squares[0] & 7) > 3) {
+		mirror ^= 7;
+	}
+	if(!m_pawns && ((squares[0] ^ mirror) >> 3) > 3) {
+		mirror ^= 56;
+	}
+
+	int king = squares[0] ^ mirror;
+	size_t index = (turn == Piece::WHITE ? 0 : m_kingsquares) + (king >> 3)*4 + (king & 7);
+	for(int i = 1; i < m_men; i++) {
+		index = index*64 + (squares[i] ^ mirror);
+	}
+	return index;
+}
+
+void EndgameTable::position(size_t index, int * squares, Piece::Color & turn) const
+{
+	for(int i = m_men - 1; i > 0; i--) {
+		squares[i] = (int)(index % 64);
+		index /= 64;
+	}
+	int king = (int)(index % m_kingsquares);
+	squares[0] = (king / 4)*8 + king % 4;
+	turn = (index < (size_t)m_kingsquares) ? Piece::WHITE : Piece::BLACK;
+}
+
+bool EndgameTable::open(const string & filename)
+{
+	if(!m_file.open(filename) || m_file.size() < (size_t)HEADER_SIZE) {
+		m_file.close();
+		return false;
+	}
+
+	const unsigned char * header = m_file.data();
+	bool valid = memcmp(header, EGTB_MAGIC, sizeof(EGTB_MAGIC)) == 0 &&
+	             header[4] == EGTB_VERSION && header[5] == m_men &&
+	             header[6] >= 1 && header[6] <= 8;
+	for(int i = 0; valid && i < m_men; i++) {
+		valid = header[8+i] == (m_color[i] << 3 | m_type[i]);
+	}
+	m_bits = header[6];
+	if(!valid || m_file.size() < HEADER_SIZE + (m_size*m_bits + 7)/8 + 1) {
+		m_file.close();
+		return false;
+	}
+	return true;
+}
+
+int EndgameTable::value(size_t index) const
+{
+	size_t bit = index * m_bits;
+	const unsigned char * p = m_file.data() + HEADER_SIZE + (bit >> 3);
+	int word = p[0] | (p[1] << 8);
+	return (word >> (bit & 7)) & ((1 << m_bits) - 1);
+}
+
+bool EndgameTable::write(const string & filename, const vector<unsigned char> & values) const
+{
+	int largest = *max_element(values.begin(), values.end());
+	int bits = 1;
+	while((1 << bits) <= largest) {
+		bits++;
+	}
+
+	vector<unsigned char> data(HEADER_SIZE + (m_size*bits + 7)/8 + 1, 0);
+	memcpy(&data[0], EGTB_MAGIC, sizeof(EGTB_MAGIC));
+	data[4] = EGTB_VERSION;
+	data[5] = m_men;
+	data[6] = bits;
+	for(int i = 0; i < EGTB_MAX_MEN; i++) {
+		data[8+i] = (i < m_men) ? (m_color[i] << 3 | m_type[i]) : 0xff;
+	}
+
+	// Entries can straddle a byte boundary, but never two
+	for(size_t i = 0; i < m_size; i++) {
+		size_t bit = i * bits;
+		int word = values[i] << (bit & 7);
+		data[HEADER_SIZE + (bit >> 3)] |= word & 0xff;
+		data[HEADER_SIZE + (bit >> 3) + 1] |= word >> 8;
+	}
+
+	ofstream out(filename.c_str(), ios::out | ios::binary);
+	out.write((const char*)&data[0], data.size());
+	return out.good();
+}
+
+EndgameTables * EndgameTables::m_instance = 0;
+
+EndgameTables * EndgameTables::getInstance()
+{
+	if(m_instance == 0) {
+		m_instance = new EndgameTables();
+		Options * opts = Options::getInstance();
+		if(!opts->egtbpath.empty()) {
+			m_instance->load(opts->egtbpath);
+		}
+	}
+	return m_instance;
+}
+
+EndgameTables::EndgameTables()
+{
+}
+
+EndgameTables::~EndgameTables()
+{
+	close();
+}
+
+int EndgameTables::load(const string & directory)
+{
+	close();
+	vector<string> names = allTables();
+	for(int i = 0; i < (int)names.size(); i++) {
+		open(directory, names[i]);
+	}
+	return size();
+}
+
+bool EndgameTables::open(const string & directory, const string & name)
+{
+	EndgameTable * table = new EndgameTable(name);
+	if(!table->open(fileName(directory, name))) {
+		delete table;
+		return false;
+	}
+
+	map<string, EndgameTable*>::iterator it = m_tables.find(name);
+	if(it != m_tables.end()) {
+		delete it->second;
+	}
+	m_tables[name] = table;
+	return true;
+}
+
+void EndgameTables::close()
+{
+	map<string, EndgameTable*>::iterator it;
+	for(it = m_tables.begin(); it != m_tables.end(); ++it) {
+		delete it->second;
+	}
+	m_tables.clear();
+}
+
+bool EndgameTables::probe(const EndgamePosition & pos, Result & result, int & plies) const
+{
+	bool flip;
+	string name = tableName(pos, flip);
+	if(isInsufficient(name)) {
+		result = DRAW;
+		plies = 0;
+		return true;
+	}
+
+	map<string, EndgameTable*>::const_iterator it = m_tables.find(name);
+	if(it == m_tables.end()) {
+		return false;
+	}
+	const EndgameTable & table = *it->second;
+
+	// Line the men up in the table's order, turning the board around if
+	// the stronger side is black
+	int squares[EGTB_MAX_MEN];
+	bool used[EGTB_MAX_MEN] = { false };
+	for(int i = 0; i < table.men(); i++) {
+		for(int j = 0; j < pos.count; j++) {
+			Piece::Color c = flip ? Piece::opposite(pos.color[j]) : pos.color[j];
+			if(!used[j] && c == table.color(i) && pos.type[j] == table.type(i)) {
+				squares[i] = flip ? (pos.square[j] ^ 56) : pos.square[j];
+				used[j] = true;
+				break;
+			}
+		}
+	}
+	Piece::Color turn = flip ? Piece::opposite(pos.turn) : pos.turn;
+
+	int value = table.value(table.index(squares, turn));
+	if(value == 0) {
+		result = DRAW;
+		plies = 0;
+	} else {
+		plies = value - 1;
+		result = (plies % 2) ? WIN : LOSS;
+	}
+	return true;
+}
+
+bool EndgameTables::probe(const Board & board, Piece::Color c, Result & result, int & plies) const
+{
+	unsigned long long men = board.getPieces(Piece::WHITE).getBoard() |
+	                         board.getPieces(Piece::BLACK).getBoard();
+	if(popCount(men) > EGTB_MAX_MEN) {
+		return false;
+	}
+
+	// The tables leave out en passant and castling, so they can't answer
+	// when either is possible
+	if(board.canCaptureEnPassant(c)) {
+		return false;
+	}
+	for(int side = 0; side <= Piece::LAST_COLOR; side++) {
+		if(board.canCastle(Piece::Color(side), true) || board.canCastle(Piece::Color(side), false)) {
+			return false;
+		}
+	}
+
+	EndgamePosition pos;
+	pos.set(board, c);
+	return probe(pos, result, plies);
+}
+
+string EndgameTables::tableName(const EndgamePosition & pos, bool & flip)
+{
+	string sides[Piece::LAST_COLOR + 1];
+	for(int c = 0; c <= Piece::LAST_COLOR; c++) {
+		sides[c] = "K";
+		for(int t = 0; t < NUM_TABLE_PIECES; t++) {
+			for(int i = 0; i < pos.count; i++) {
+				if(pos.color[i] == c && pos.type[i] == TABLE_ORDER[t]) {
+					sides[c] += TABLE_LETTERS[t];
+				}
+			}
+		}
+	}
+
+	flip = isStronger(sides[Piece::BLACK], sides[Piece::WHITE]);
+	return flip ? sides[Piece::BLACK] + sides[Piece::WHITE] :
+	              sides[Piece::WHITE] + sides[Piece::BLACK];
+}
+
+bool EndgameTables::isInsufficient(const string & name)
+{
+	return name == "KK" || name == "KNK" || name == "KBK";
+}
+
+vector<string> EndgameTables::allTables()
+{
+	// Every side of up to two pieces besides the king
+	vector<string> sides;
+	sides.push_back("K");
+	for(int i = 0; i < NUM_TABLE_PIECES; i++) {
+		sides.push_back(string("K") + TABLE_LETTERS[i]);
+	}
+	for(int i = 0; i < NUM_TABLE_PIECES; i++) {
+		for(int j = i; j < NUM_TABLE_PIECES; j++) {
+			sides.push_back(string("K") + TABLE_LETTERS[i] + TABLE_LETTERS[j]);
+		}
+	}
+
+	vector<string> names;
+	for(int w = 0; w < (int)sides.size(); w++) {
+		for(int b = 0; b < (int)sides.size(); b++) {
+			string name = sides[w] + sides[b];
+			if((int)name.size() <= EGTB_MAX_MEN && !isStronger(sides[b], sides[w]) &&
+			   !isInsufficient(name)) {
+				names.push_back(name);
+			}
+		}
+	}
+	stable_sort(names.begin(), names.end(), smallerTable);
+	return names;
+}
+
+string EndgameTables::fileName(const string & directory, const string & name)
+{
+	return directory + "/" + name + ".egtb";
+}
+
+// End of file egtb.cpp
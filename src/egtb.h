@@ -0,0 +1,199 @@
+/***************************************************************************
+ * Brutal Chess
+ * http://brutalchess.sf.net
+ *
+ * File : egtb.h
+ * Authors : Mike Cook, Joe Flint, Neil Pankey
+ **************************************************************************/
+
+#ifndef EGTB_H
+#define EGTB_H
+
+#include "board.h"
+#include "mappedfile.h"
+#include "piece.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+/** Most men, kings included, in any endgame table */
+const int EGTB_MAX_MEN = 4;
+
+/**
+ * A position small enough to be in the endgame tables, kept as a list of
+ * men rather than a whole Board so the table generator can work on it
+ * cheaply.
+ */
+struct EndgamePosition {
+	/** Builds the position of board with color c to move. */
+	void set(const Board & board, Piece::Color c);
+
+	int count;
+	Piece::Color color[EGTB_MAX_MEN];
+	Piece::Type type[EGTB_MAX_MEN];
+	int square[EGTB_MAX_MEN];
+	Piece::Color turn;
+};
+
+/**
+ * The layout of one table, and the table itself once it has been mapped.
+ *
+ * A table is named after its material with the stronger side first, e.g.
+ * KQKR, and always has the stronger side as white. Its men are listed
+ * white king, white pieces, black king, black pieces with the pieces in
+ * the order Q, R, B, N, P. Every arrangement of the men with either side
+ * to move has an entry, bar those the board's symmetry makes redundant:
+ * the white king is always on files a-d, and on ranks 1-4 too if there
+ * are no pawns.
+ *
+ * Entries are packed into the minimum number of bits that holds the
+ * largest. An entry of 0 is a draw, or a position that can't happen. Any
+ * other entry e means mate in e-1 plies with best play, so a side to
+ * move with an odd number of plies left is winning and one with an even
+ * number is being mated.
+ */
+class EndgameTable {
+ public:
+	/** Lays out the table for the named material, e.g. "KRPK". */
+	EndgameTable(const std::string & name);
+
+	const std::string & name() const
+		{ return m_name; }
+
+	/** Number of men, kings included */
+	int men() const
+		{ return m_men; }
+
+	Piece::Color color(int i) const
+		{ return m_color[i]; }
+
+	Piece::Type type(int i) const
+		{ return m_type[i]; }
+
+	bool hasPawns() const
+		{ return m_pawns; }
+
+	/** Number of entries in the table */
+	size_t size() const
+		{ return m_size; }
+
+	/**
+	 * Returns the entry for the men on the given squares, listed in the
+	 * table's order, with turn to move.
+	 */
+	size_t index(const int * squares, Piece::Color turn) const;
+
+	/**
+	 * The reverse of index. The squares may clash, entries for impossible
+	 * positions exist too.
+	 */
+	void position(size_t index, int * squares, Piece::Color & turn) const;
+
+	/** Maps the table from filename, returning false if it isn't valid. */
+	bool open(const std::string & filename);
+
+	bool isOpen() const
+		{ return m_file.isOpen(); }
+
+	/** Returns the entry at index from the mapped table. */
+	int value(size_t index) const;
+
+	/**
+	 * Writes a table holding the given entries to filename, returning false
+	 * if the file couldn't be written.
+	 */
+	bool write(const std::string & filename, const std::vector<unsigned char> & values) const;
+
+	/** Size of the header before the packed entries */
+	static const int HEADER_SIZE = 16;
+
+ private:
+	std::string m_name;
+	int m_men;
+	Piece::Color m_color[EGTB_MAX_MEN];
+	Piece::Type m_type[EGTB_MAX_MEN];
+	bool m_pawns;
+	size_t m_size;
+
+	// Squares the white king can be on after the symmetry is taken out
+	int m_kingsquares;
+
+	int m_bits;
+	MappedFile m_file;
+
+	// Tables are shared, not copied
+	EndgameTable(const EndgameTable &);
+	EndgameTable & operator=(const EndgameTable &);
+};
+
+/**
+ * Every endgame table found in a directory, looked up by the material of
+ * the position being probed.
+ */
+class EndgameTables {
+ public:
+	/** What the side to move gets with best play */
+	enum Result { LOSS = -1, DRAW = 0, WIN = 1 };
+
+	/** Returns the tables in the directory named in the Options. */
+	static EndgameTables * getInstance();
+
+	EndgameTables();
+
+	~EndgameTables();
+
+	/**
+	 * Maps every table in the directory, returning how many there were. A
+	 * missing directory is fine, it just means there are no tables.
+	 */
+	int load(const std::string & directory);
+
+	/** Maps the named table from the directory, returning false if it isn't there. */
+	bool open(const std::string & directory, const std::string & name);
+
+	/** Unmaps all the tables. */
+	void close();
+
+	/** Number of tables mapped */
+	int size() const
+		{ return (int)m_tables.size(); }
+
+	/**
+	 * Looks the position up. Returns false if there is no table for it,
+	 * otherwise result is the outcome for the side to move and plies the
+	 * number of plies until mate.
+	 */
+	bool probe(const EndgamePosition & pos, Result & result, int & plies) const;
+
+	/** Looks up board with color c to move. */
+	bool probe(const Board & board, Piece::Color c, Result & result, int & plies) const;
+
+	/**
+	 * Returns the table name for the material in pos. flip is set when the
+	 * stronger side is black, so pos has to be turned around to fit.
+	 */
+	static std::string tableName(const EndgamePosition & pos, bool & flip);
+
+	/** Returns true if neither side has enough material to mate. */
+	static bool isInsufficient(const std::string & name);
+
+	/** Names of every table worth having, smallest first. */
+	static std::vector<std::string> allTables();
+
+	/** File a table is kept in, within its directory */
+	static std::string fileName(const std::string & directory, const std::string & name);
+
+ private:
+	std::map<std::string, EndgameTable*> m_tables;
+
+	static EndgameTables * m_instance;
+
+	// Tables are shared, not copied
+	EndgameTables(const EndgameTables &);
+	EndgameTables & operator=(const EndgameTables &);
+};
+
+#endif
+
+// End of file egtb.h
@@ -0,0 +1,714 @@
+/***************************************************************************
+ * Brutal Chess
+ * http://brutalchess.sf.net
+ *
+ * File : egtbgen.cpp
+ * Authors : Mike Cook, Joe Flint, Neil Pankey
+ **************************************************************************/
+
+#include "board.h"
+#include "egtb.h"
+#include "options.h"
+#include "SDL.h"
+#include "SDL_thread.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Entry for a position that can't happen, only used while generating
+static const unsigned char ILLEGAL = 0xff;
+
+// Longest mate a table can hold, in plies
+static const int MAX_PLIES = 253;
+
+// Entries handed to a thread at a time
+static const size_t CHUNK_SIZE = 1 << 14;
+
+static const int STRAIGHT[4][2] = { {1, 0}, {-1, 0}, {0, 1}, {0, -1} };
+static const int DIAGONAL[4][2] = { {1, 1}, {1, -1}, {-1, 1}, {-1, -1} };
+
+static unsigned long long bit(int sq)
+{
+	return 1ULL << sq;
+}
+
+// Squares a slider on sq reaches in the given directions
+static unsigned long long slide(int sq, unsigned long long occupied, const int directions[4][2])
+{
+	unsigned long long attacks = 0;
+	for(int d = 0; d < 4; d++) {
+		int file = sq & 7, rank = sq >> 3;
+		for(;;) {
+			file += directions[d][0];
+			rank += directions[d][1];
+			if(file < 0 || file > 7 || rank < 0 || rank > 7) {
+				break;
+			}
+			attacks |= bit(rank*8 + file);
+			if(occupied & bit(rank*8 + file)) {
+				break;
+			}
+		}
+	}
+	return attacks;
+}
+
+static unsigned long long attacks(Piece::Type t, Piece::Color c, int sq, unsigned long long occupied)
+{
+	switch(t) {
+		case Piece::KING:
+			return Board::kingAttacks[sq];
+		case Piece::KNIGHT:
+			return Board::knightAttacks[sq];
+		case Piece::BISHOP:
+			return slide(sq, occupied, DIAGONAL);
+		case Piece::ROOK:
+			return slide(sq, occupied, STRAIGHT);
+		case Piece::QUEEN:
+			return slide(sq, occupied, DIAGONAL) | slide(sq, occupied, STRAIGHT);
+		case Piece::PAWN:
+			return Board::pawnAttacks[c][sq];
+		default:
+			return 0;
+	}
+}
+
+/**
+ * Builds one table by retrograde analysis. Every position is first
+ * scored from its moves that leave the table, captures and promotions,
+ * using the smaller tables already built. Then, a ply at a time, the
+ * positions decided at that ply are unmoved: the positions before a loss
+ * are wins one ply longer, and the positions before a win are checked to
+ * see whether every move now loses. Whatever is never decided is a draw.
+ *
+ * Each pass over the table is split between threads a chunk at a time.
+ * Threads only ever write the same value to an entry within a pass, so
+ * they can share the table without locking.
+ */
+class TableGenerator {
+ public:
+	TableGenerator(const string & name, const EndgameTables & done, int threads);
+
+	~TableGenerator();
+
+	/** Works out every entry in the table. */
+	void generate();
+
+	/** Writes the finished table, returning false if it couldn't be. */
+	bool write(const string & filename);
+
+	/** Longest mate found, in plies */
+	int longest() const
+		{ return m_longest; }
+
+	/** Number of wins for the side to move */
+	size_t wins() const;
+
+ private:
+	enum Pass { INIT, SEED, PUSH, VERIFY };
+
+	/** A move within the generator's compact position */
+	struct Move {
+		int man;
+		int to;
+		int captured;
+		Piece::Type promotion;
+	};
+
+	/** Runs a pass over the whole table on every thread. */
+	void run(Pass pass);
+
+	static int worker(void * data);
+
+	void initEntry(size_t index, int & longest);
+	void pushEntry(size_t index, int & longest);
+	void verifyEntry(size_t index, int & longest);
+
+	/**
+	 * Decodes an entry into squares, returning false for positions that
+	 * can't happen: men on the same square, pawns on the end ranks or the
+	 * side that just moved in check.
+	 */
+	bool decode(size_t index, int * squares, Piece::Color & turn) const;
+
+	/** True if square sq is attacked by color by. Men with a negative square are gone. */
+	bool isAttacked(const int * squares, int sq, Piece::Color by) const;
+
+	/** Returns the legal moves for turn in moves, at most 64 of them. */
+	int generateMoves(const int * squares, Piece::Color turn, Move * moves) const;
+
+	/** Plays move, leaving the position it leads to in after. */
+	void makeMove(const int * squares, const Move & move, int * after) const;
+
+	/**
+	 * Scores a move that leaves the table from the smaller tables, as the
+	 * outcome for the side to move after it.
+	 */
+	void probeExit(const int * after, const Move & move, Piece::Color turn,
+	               EndgameTables::Result & result, int & plies) const;
+
+	EndgameTable m_table;
+	const EndgameTables & m_done;
+	int m_threads;
+
+	// Which of the table's men are the kings
+	int m_king[Piece::LAST_COLOR + 1];
+
+	// The entry of each position, 0 while undecided, else plies to mate + 1
+	vector<unsigned char> m_values;
+	// Quickest win through a capture or promotion, in plies
+	vector<unsigned char> m_exitwin;
+	// Undecided positions a move away from a newly decided win
+	vector<unsigned char> m_candidate;
+
+	// The pass being run and how far through the table the threads are
+	Pass m_pass;
+	int m_ply;
+	size_t m_next;
+	SDL_mutex * m_lock;
+	int m_longest;
+};
+
+TableGenerator::TableGenerator(const string & name, const EndgameTables & done, int threads) :
+	m_table(name),
+	m_done(done),
+	m_threads(threads),
+	m_pass(INIT),
+	m_ply(0),
+	m_next(0),
+	m_longest(0)
+{
+	for(int i = 0; i < m_table.men(); i++) {
+		if(m_table.type(i) == Piece::KING) {
+			m_king[m_table.color(i)] = i;
+		}
+	}
+	m_lock = SDL_CreateMutex();
+}
+
+TableGenerator::~TableGenerator()
+{
+	SDL_DestroyMutex(m_lock);
+}
+
+void TableGenerator::generate()
+{
+	m_values.assign(m_table.size(), 0);
+	m_exitwin.assign(m_table.size(), 0);
+	m_candidate.assign(m_table.size(), 0);
+
+	run(INIT);
+
+	// m_longest grows as longer mates are found, so this runs until a ply
+	// passes without anything left to decide
+	for(m_ply = 0; m_ply <= m_longest && m_ply < MAX_PLIES; m_ply++) {
+		if(m_ply % 2) {
+			run(SEED);
+		}
+		run(PUSH);
+		if(m_ply % 2) {
+			run(VERIFY);
+		}
+	}
+
+	// Impossible positions are never probed, store them as draws
+	replace(m_values.begin(), m_values.end(), ILLEGAL, (unsigned char)0);
+	m_exitwin.clear();
+	m_candidate.clear();
+}
+
+bool TableGenerator::write(const string & filename)
+{
+	return m_table.write(filename, m_values);
+}
+
+size_t TableGenerator::wins() const
+{
+	size_t count = 0;
+	for(size_t i = 0; i < m_values.size(); i++) {
+		if(m_values[i] % 2 == 0 && m_values[i] != 0) {
+			count++;
+		}
+	}
+	return count;
+}
+
+void TableGenerator::run(Pass pass)
+{
+	m_pass = pass;
+	m_next = 0;
+
+	vector<SDL_Thread*> handles;
+	for(int i = 1; i < m_threads; i++) {
+		SDL_Thread * thread = SDL_CreateThread(worker, this);
+		if(thread == NULL) {
+			cerr << "Unable to create generator thread: " << SDL_GetError() << endl;
+			break;
+		}
+		handles.push_back(thread);
+	}
+	worker(this);
+	for(int i = 0; i < (int)handles.size(); i++) {
+		SDL_WaitThread(handles[i], NULL);
+	}
+}
+
+int TableGenerator::worker(void * data)
+{
+	TableGenerator * gen = (TableGenerator*)data;
+	int longest = 0;
+
+	for(;;) {
+		SDL_LockMutex(gen->m_lock);
+		size_t begin = gen->m_next;
+		gen->m_next += CHUNK_SIZE;
+		SDL_UnlockMutex(gen->m_lock);
+
+		if(begin >= gen->m_table.size()) {
+			break;
+		}
+		size_t end = min(begin + CHUNK_SIZE, gen->m_table.size());
+
+		for(size_t i = begin; i < end; i++) {
+			switch(gen->m_pass) {
+				case INIT:
+					gen->initEntry(i, longest);
+					break;
+				case SEED:
+					if(gen->m_values[i] == 0 && gen->m_exitwin[i] == gen->m_ply) {
+						gen->m_values[i] = gen->m_ply + 1;
+					}
+					break;
+				case PUSH:
+					if(gen->m_values[i] == gen->m_ply + 1) {
+						gen->pushEntry(i, longest);
+					}
+					break;
+				case VERIFY:
+					if(gen->m_candidate[i]) {
+						gen->m_candidate[i] = 0;
+						gen->verifyEntry(i, longest);
+					}
+					break;
+			}
+		}
+	}
+
+	SDL_LockMutex(gen->m_lock);
+	gen->m_longest = max(gen->m_longest, min(longest, MAX_PLIES));
+	SDL_UnlockMutex(gen->m_lock);
+	return 0;
+}
+
+void TableGenerator::initEntry(size_t index, int & longest)
+{
+	int squares[EGTB_MAX_MEN];
+	Piece::Color turn;
+	if(!decode(index, squares, turn)) {
+		m_values[index] = ILLEGAL;
+		return;
+	}
+
+	Move moves[64];
+	int count = generateMoves(squares, turn, moves);
+	if(count == 0) {
+		// Mated, or stalemate which is left as a draw
+		if(isAttacked(squares, squares[m_king[turn]], Piece::opposite(turn))) {
+			m_values[index] = 1;
+		}
+		return;
+	}
+
+	int internal = 0, win = -1, loss = -1;
+	bool draw = false;
+	for(int i = 0; i < count; i++) {
+		if(moves[i].captured < 0 && moves[i].promotion == Piece::NOTYPE) {
+			internal++;
+			continue;
+		}
+		int after[EGTB_MAX_MEN];
+		makeMove(squares, moves[i], after);
+		EndgameTables::Result result;
+		int plies;
+		probeExit(after, moves[i], Piece::opposite(turn), result, plies);
+		if(result == EndgameTables::LOSS && (win < 0 || plies + 1 < win)) {
+			win = plies + 1;
+		} else if(result == EndgameTables::WIN) {
+			loss = max(loss, plies + 1);
+		} else if(result == EndgameTables::DRAW) {
+			draw = true;
+		}
+	}
+
+	if(win >= 0) {
+		m_exitwin[index] = min(win, MAX_PLIES);
+		longest = max(longest, win);
+	} else if(internal == 0 && !draw) {
+		// Every move leaves the table and loses
+		m_values[index] = min(loss, MAX_PLIES) + 1;
+		longest = max(longest, loss);
+	}
+}
+
+void TableGenerator::pushEntry(size_t index, int & longest)
+{
+	int squares[EGTB_MAX_MEN];
+	Piece::Color turn;
+	decode(index, squares, turn);
+	Piece::Color moved = Piece::opposite(turn);
+
+	unsigned long long occupied = 0;
+	for(int i = 0; i < m_table.men(); i++) {
+		occupied |= bit(squares[i]);
+	}
+
+	int before[EGTB_MAX_MEN];
+	for(int i = 0; i < m_table.men(); i++) {
+		if(m_table.color(i) != moved) {
+			continue;
+		}
+
+		// Where the man could have come from, without capturing
+		unsigned long long from = 0;
+		int sq = squares[i];
+		if(m_table.type(i) == Piece::PAWN) {
+			int back = (moved == Piece::WHITE) ? -8 : 8;
+			int rank = (sq + back) >> 3;
+			if(rank >= 1 && rank <= 6 && !(occupied & bit(sq + back))) {
+				from |= bit(sq + back);
+				int start = (moved == Piece::WHITE) ? 1 : 6;
+				if(rank + (back > 0 ? 1 : -1) == start && !(occupied & bit(sq + 2*back))) {
+					from |= bit(sq + 2*back);
+				}
+			}
+		} else {
+			from = attacks(m_table.type(i), moved, sq, occupied) & ~occupied;
+		}
+
+		for(; from; from &= from - 1) {
+			copy(squares, squares + m_table.men(), before);
+			before[i] = bitScanForward(from);
+
+			// The side now to move can't have been left in check
+			if(isAttacked(before, before[m_king[turn]], moved)) {
+				continue;
+			}
+
+			size_t prev = m_table.index(before, moved);
+			if(m_values[prev] != 0) {
+				continue;
+			}
+			if(m_ply % 2 == 0) {
+				// A move to a lost position wins
+				m_values[prev] = m_ply + 2;
+				longest = max(longest, m_ply + 1);
+			} else {
+				m_candidate[prev] = 1;
+			}
+		}
+	}
+}
+
+void TableGenerator::verifyEntry(size_t index, int & longest)
+{
+	if(m_values[index] != 0) {
+		return;
+	}
+
+	int squares[EGTB_MAX_MEN];
+	Piece::Color turn;
+	decode(index, squares, turn);
+
+	// Lost only if every move leads to a win for the other side, and then
+	// as late as possible
+	Move moves[64];
+	int count = generateMoves(squares, turn, moves);
+	int worst = -1;
+	for(int i = 0; i < count; i++) {
+		int after[EGTB_MAX_MEN];
+		makeMove(squares, moves[i], after);
+		int plies;
+		if(moves[i].captured < 0 && moves[i].promotion == Piece::NOTYPE) {
+			int value = m_values[m_table.index(after, Piece::opposite(turn))];
+			if(value == 0 || value == ILLEGAL || (value - 1) % 2 == 0) {
+				return;
+			}
+			plies = value - 1;
+		} else {
+			EndgameTables::Result result;
+			probeExit(after, moves[i], Piece::opposite(turn), result, plies);
+			if(result != EndgameTables::WIN) {
+				return;
+			}
+		}
+		worst = max(worst, plies);
+	}
+
+	if(worst >= 0) {
+		m_values[index] = min(worst + 1, MAX_PLIES) + 1;
+		longest = max(longest, worst + 1);
+	}
+}
+
+bool TableGenerator::decode(size_t index, int * squares, Piece::Color & turn) const
+{
+	m_table.position(index, squares, turn);
+
+	unsigned long long occupied = 0;
+	for(int i = 0; i < m_table.men(); i++) {
+		if(occupied & bit(squares[i])) {
+			return false;
+		}
+		occupied |= bit(squares[i]);
+		int rank = squares[i] >> 3;
+		if(m_table.type(i) == Piece::PAWN && (rank == 0 || rank == 7)) {
+			return false;
+		}
+	}
+
+	return !isAttacked(squares, squares[m_king[Piece::opposite(turn)]], turn);
+}
+
+bool TableGenerator::isAttacked(const int * squares, int sq, Piece::Color by) const
+{
+	unsigned long long occupied = 0;
+	for(int i = 0; i < m_table.men(); i++) {
+		if(squares[i] >= 0) {
+			occupied |= bit(squares[i]);
+		}
+	}
+	for(int i = 0; i < m_table.men(); i++) {
+		if(squares[i] >= 0 && m_table.color(i) == by &&
+		   (attacks(m_table.type(i), by, squares[i], occupied) & bit(sq))) {
+			return true;
+		}
+	}
+	return false;
+}
+
+int TableGenerator::generateMoves(const int * squares, Piece::Color turn, Move * moves) const
+{
+	unsigned long long own = 0, other = 0;
+	for(int i = 0; i < m_table.men(); i++) {
+		if(m_table.color(i) == turn) {
+			own |= bit(squares[i]);
+		} else {
+			other |= bit(squares[i]);
+		}
+	}
+	unsigned long long occupied = own | other;
+
+	int count = 0;
+	for(int i = 0; i < m_table.men(); i++) {
+		if(m_table.color(i) != turn) {
+			continue;
+		}
+		int sq = squares[i];
+		unsigned long long to;
+		if(m_table.type(i) == Piece::PAWN) {
+			int forward = (turn == Piece::WHITE) ? 8 : -8;
+			int start = (turn == Piece::WHITE) ? 1 : 6;
+			to = Board::pawnAttacks[turn][sq] & other;
+			if(!(occupied & bit(sq + forward))) {
+				to |= bit(sq + forward);
+				if((sq >> 3) == start && !(occupied & bit(sq + 2*forward))) {
+					to |= bit(sq + 2*forward);
+				}
+			}
+		} else {
+			to = attacks(m_table.type(i), turn, sq, occupied) & ~own;
+		}
+
+		for(; to; to &= to - 1) {
+			Move move;
+			move.man = i;
+			move.to = bitScanForward(to);
+			move.captured = -1;
+			move.promotion = Piece::NOTYPE;
+			for(int j = 0; j < m_table.men(); j++) {
+				if(j != i && squares[j] == move.to) {
+					move.captured = j;
+				}
+			}
+
+			int after[EGTB_MAX_MEN];
+			makeMove(squares, move, after);
+			if(isAttacked(after, after[m_king[turn]], Piece::opposite(turn))) {
+				continue;
+			}
+
+			int rank = move.to >> 3;
+			if(m_table.type(i) == Piece::PAWN && (rank == 0 || rank == 7)) {
+				static const Piece::Type promotions[] = {
+					Piece::QUEEN, Piece::ROOK, Piece::BISHOP, Piece::KNIGHT
+				};
+				for(int p = 0; p < 4; p++) {
+					move.promotion = promotions[p];
+					moves[count++] = move;
+				}
+			} else {
+				moves[count++] = move;
+			}
+		}
+	}
+	return count;
+}
+
+void TableGenerator::makeMove(const int * squares, const Move & move, int * after) const
+{
+	copy(squares, squares + m_table.men(), after);
+	after[move.man] = move.to;
+	if(move.captured >= 0) {
+		after[move.captured] = -1;
+	}
+}
+
+void TableGenerator::probeExit(const int * after, const Move & move, Piece::Color turn,
+                               EndgameTables::Result & result, int & plies) const
+{
+	EndgamePosition pos;
+	pos.count = 0;
+	pos.turn = turn;
+	for(int i = 0; i < m_table.men(); i++) {
+		if(after[i] < 0) {
+			continue;
+		}
+		pos.color[pos.count] = m_table.color(i);
+		pos.type[pos.count] = (i == move.man && move.promotion != Piece::NOTYPE) ?
+		                      move.promotion : m_table.type(i);
+		pos.square[pos.count] = after[i];
+		pos.count++;
+	}
+
+	if(!m_done.probe(pos, result, plies)) {
+		// Tables are built smallest first so this can't happen
+		result = EndgameTables::DRAW;
+		plies = 0;
+	}
+}
+
+// Adds the tables a capture or promotion in name can lead to, and theirs
+static void addTables(const string & name, set<string> & tables)
+{
+	if(tables.count(name) || EndgameTables::isInsufficient(name)) {
+		return;
+	}
+	tables.insert(name);
+
+	EndgameTable table(name);
+	for(int i = 0; i < table.men(); i++) {
+		if(table.type(i) == Piece::KING) {
+			continue;
+		}
+
+		// The position's details don't matter, only its material
+		EndgamePosition pos;
+		pos.turn = Piece::WHITE;
+		pos.count = 0;
+		for(int j = 0; j < table.men(); j++) {
+			if(j != i) {
+				pos.color[pos.count] = table.color(j);
+				pos.type[pos.count] = table.type(j);
+				pos.square[pos.count] = j;
+				pos.count++;
+			}
+		}
+		bool flip;
+		addTables(EndgameTables::tableName(pos, flip), tables);
+
+		if(table.type(i) == Piece::PAWN) {
+			static const Piece::Type promotions[] = {
+				Piece::QUEEN, Piece::ROOK, Piece::BISHOP, Piece::KNIGHT
+			};
+			pos.color[pos.count] = table.color(i);
+			pos.square[pos.count] = i;
+			pos.count++;
+			for(int p = 0; p < 4; p++) {
+				pos.type[pos.count-1] = promotions[p];
+				addTables(EndgameTables::tableName(pos, flip), tables);
+			}
+		}
+	}
+}
+
+void printEgtbUsage()
+{
+	cerr << "Usage: brutalegtb [--dir=DIR] [--threads=N] [TABLE ...]" << endl << endl;
+	cerr << " --dir=DIR\t Where to write the tables, the game's table directory by default." << endl;
+	cerr << " --threads=N\t Number of threads to generate with, 1 by default." << endl;
+	cerr << " TABLE\t\t Tables to build, e.g. KRK KQKR, all of up to " << EGTB_MAX_MEN;
+	cerr << " men by default." << endl;
+	cerr << "\t\t The tables they depend on are built too." << endl;
+	exit(1);
+}
+
+int main(int argc, char * argv[])
+{
+	string directory = Options::getInstance()->egtbpath;
+	int threads = 1;
+	vector<string> all = EndgameTables::allTables();
+	set<string> wanted;
+
+	for(int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		if(arg.substr(0, 6) == "--dir=") {
+			directory = arg.substr(6);
+		} else if(arg.substr(0, 10) == "--threads=") {
+			threads = atoi(arg.substr(10).c_str());
+			if(threads < 1) {
+				printEgtbUsage();
+			}
+		} else if(find(all.begin(), all.end(), arg) != all.end()) {
+			addTables(arg, wanted);
+		} else {
+			cerr << "Unknown table " << arg << ", the stronger side goes first e.g. KQKR" << endl;
+			printEgtbUsage();
+		}
+	}
+	if(wanted.empty()) {
+		wanted.insert(all.begin(), all.end());
+	}
+
+	if(SDL_Init(SDL_INIT_TIMER) < 0) {
+		cerr << "Timer initialization failed: " << SDL_GetError() << endl;
+		return 1;
+	}
+	Board::init();
+
+	// Smallest first, so every table a capture or promotion leads to is
+	// ready before it's needed
+	EndgameTables done;
+	for(int i = 0; i < (int)all.size(); i++) {
+		const string & name = all[i];
+		if(!wanted.count(name)) {
+			continue;
+		}
+		if(done.open(directory, name)) {
+			cout << name << " already built" << endl;
+			continue;
+		}
+
+		Uint32 start = SDL_GetTicks();
+		TableGenerator gen(name, done, threads);
+		gen.generate();
+		string filename = EndgameTables::fileName(directory, name);
+		if(!gen.write(filename) || !done.open(directory, name)) {
+			cerr << "Unable to write " << filename << endl;
+			SDL_Quit();
+			return 1;
+		}
+		cout << name << ": " << gen.wins() << " wins, longest mate " << gen.longest();
+		cout << " plies, " << SDL_GetTicks() - start << " ms" << endl;
+	}
+
+	SDL_Quit();
+	return 0;
+}
+
+// End of file egtbgen.cpp
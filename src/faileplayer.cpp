@@ -12,43 +12,98 @@
 #include "chessplayer.h"
 
 #include <cassert>
+#include <iomanip>
+#include <poll.h>
 #include <sstream>
 #include <string>
+#include <sys/wait.h>
+#include <unistd.h>
 
 using namespace std;
 
 FailePlayer::FailePlayer()
 {
 	m_trustworthy = true;
+	m_initialized = false;
+	m_pid = 0;
+	m_turn = Piece::WHITE;
+	m_forced = false;
+	m_level = false;
 }
 
 FailePlayer::~FailePlayer()
 {
-	write(m_to[1], "exit\n", 5);
+	if (m_initialized) {
+		write(m_to[1], "exit\n", 5);
+		close(m_to[1]);
+		close(m_from[0]);
+		waitpid(m_pid, NULL, 0);
+	}
 }
 
 void FailePlayer::newGame()
 {
 	runChessEngine();
+	m_turn = Piece::WHITE;
+	m_forced = false;
+	m_level = false;
 }
 
 void FailePlayer::loadGame(const ChessGameState& cgs)
 {
+	if (!m_initialized)
+		runChessEngine();
+
+	// Set the position up in force mode so the engine doesn't move for
+	// either side, it is told to go once it's its turn
+	string setup = "force\nsetboard " + cgs.toFEN() + "\n";
+	write(m_to[1], setup.c_str(), setup.size());
+	m_turn = cgs.getTurn();
+	m_forced = true;
 }
 
 void FailePlayer::startGame()
 {
-	if(m_is_white)
+	if (getColor() == m_turn) {
 		write(m_to[1], "go\n", 3);
+		m_forced = false;
+	}
+}
+
+void FailePlayer::setClock(unsigned int remaining, unsigned int increment)
+{
+	if (!m_initialized)
+		runChessEngine();
+
+	// The first clock is the whole time control, in minutes and seconds,
+	// after that the engine is told what's left in centiseconds
+	ostringstream out;
+	if (!m_level) {
+		out << "level 0 " << remaining / 60000 << ":" << setw(2) << setfill('0');
+		out << remaining / 1000 % 60 << " " << increment / 1000.0 << "\n";
+		m_level = true;
+	}
+	out << "time " << remaining / 10 << "\n";
+	string command = out.str();
+	write(m_to[1], command.c_str(), command.size());
 }
 
 // Set up gnuchess
 void FailePlayer::runChessEngine()
 {
+	// One engine per player, shut down the last game's
+	if (m_initialized) {
+		write(m_to[1], "exit\n", 5);
+		close(m_to[1]);
+		close(m_from[0]);
+		waitpid(m_pid, NULL, 0);
+	}
+
 	pipe( m_to );
 	pipe( m_from );
 
-	if (fork() == 0) {
+	m_pid = fork();
+	if (m_pid == 0) {
 		// Child Process
 		nice( 20 );
 		dup2( m_to[0], 0 );
@@ -58,7 +113,10 @@ void FailePlayer::runChessEngine()
 		close( m_from[0] );
 		execvp( "./faile", NULL );
 		cerr << "Couldn't run faile" << endl;
+		_exit(1);
 	}
+	close( m_to[0] );
+	close( m_from[1] );
 	write( m_to[1], "xboard\n", 7);
 	m_initialized = true;
 }
@@ -72,6 +130,14 @@ void FailePlayer::think(const ChessGameState & cgs)
 	string output;
 	char c;
 	while ( output.substr(0, 5) != "move ") {
+		// Wake up now and then to see if the game has moved on without us
+		pollfd pfd = { m_from[0], POLLIN, 0 };
+		while (!m_interrupted && poll(&pfd, 1, 50) == 0)
+			;
+		if (m_interrupted) {
+			m_move.invalidate();
+			return;
+		}
 		output = "";
 		while ( read( m_from[0], &c, 1 ) ) {
 			if ( c == '\n' )
@@ -103,8 +169,6 @@ void FailePlayer::think(const ChessGameState & cgs)
 
 	Board b = cgs.getBoard();
 	BoardMove move(origin, dest, b.getPiece(origin));
-	printf("Pawn promotion: %d\n", promote);
-	cout << promote << endl;
 	m_move = move;
 }
 
@@ -129,6 +193,12 @@ void FailePlayer::opponentMove(const BoardMove & move, const ChessGameState & cg
 	cout << movestr << endl;
 
 	write( m_to[1], movestr.c_str(), 5);
+
+	// Out of force mode, now the engine has a move to answer
+	if (m_forced) {
+		write( m_to[1], "go\n", 3);
+		m_forced = false;
+	}
 }
 
 void FailePlayer::undoMove()
@@ -22,6 +22,7 @@
 #include "texture.h"
 
 #include <cmath>
+#include <cstdlib>
 #include <iostream>
 
 using std::cout;
@@ -48,6 +49,9 @@ GameCore * GameCore::get_Instance()
 
 void GameCore::destroy()
 {
+	stopThinkThread();
+	delete m_hinter;
+	m_hinter = 0;
 	delete m_theme;
 	m_theme = 0;
 	delete m_set;
@@ -140,6 +144,13 @@ void GameCore::draw()
 			drawReflections();
 		}
 		
+		// Suggest the move the engine likes for a human to move
+		BoardMove hint;
+		int hintscore = 0, hintdepth = 0;
+		bool showhint = m_options->hints && m_game.getCurrentPlayer()->isHuman() &&
+			hintEngine()->getAnalysis(m_game.getBoard(), m_game.getTurn(), hint, hintscore, hintdepth);
+		m_theme->setHint(showhint ? hint : BoardMove());
+
 		// Blend the draw reflections with the board.
 		glEnable( GL_BLEND );
 		glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA );
@@ -152,6 +163,9 @@ void GameCore::draw()
 
 		m_set->draw(m_game.getState());
 
+		if(showhint) {
+			drawHintText(hintscore, hintdepth);
+		}
 
 		// Draw a spinning pawn (like the loading screen) if we are waiting on the player
 		if(!m_game.getCurrentPlayer()->isHuman()) {
@@ -189,14 +203,23 @@ void GameCore::draw()
             buildMenu();
             m_menu.pushOptionsSet("Game Over");
             string condition;
-            if (m_game.getBoard().isCheckMate(Piece::BLACK)) {
-                condition = "Checkmate - White Wins";
-            }
-            else if (m_game.getBoard().isCheckMate(Piece::WHITE)) {
-                condition = "Checkmate - Black Wins";
-            }
-            else {
-                condition = "Stalemate";
+            switch (m_game.getState().getStatus()) {
+                case ChessGameState::CHECKMATE:
+                    condition = (m_game.getTurn() == Piece::WHITE) ?
+                        "Checkmate - Black Wins" : "Checkmate - White Wins";
+                    break;
+                case ChessGameState::FIFTY_MOVE_DRAW:
+                    condition = "Draw - Fifty Move Rule";
+                    break;
+                case ChessGameState::THREEFOLD_DRAW:
+                    condition = "Draw - Threefold Repetition";
+                    break;
+                case ChessGameState::MATERIAL_DRAW:
+                    condition = "Draw - Insufficient Material";
+                    break;
+                default:
+                    condition = "Stalemate";
+                    break;
             }
             m_menu.setHeader(condition);
             m_menu.activate();
@@ -352,9 +375,17 @@ bool GameCore::handleEvent(SDL_Event& e)
 	}
 	else if (e.type == SDL_USEREVENT) {
 		if(e.user.code == 0) {
+			// A think that was stopped may have finished just before it
+			if(!m_thinkthread || (size_t)e.user.data2 != (size_t)m_thinkcount) {
+				return false;
+			}
+
 			// Received notification that the player is done thinking
 			ChessPlayer *player = (ChessPlayer*)e.user.data1;
 			//m_set->animateMove(player->getMove());
+			if(player->getSearchStats().nodes) {
+				cout << player->getSearchStats() << endl;
+			}
 			if(m_game.tryMove(player->getMove())) {
 				m_game.getCurrentPlayer()->opponentMove(player->getMove(), m_game.getState());
 				SDL_SetCursor(m_defaultcur);
@@ -365,9 +396,10 @@ bool GameCore::handleEvent(SDL_Event& e)
 			m_thinkthread = NULL;
 
 			// Only temporary, really want to do this after animation is done
-	    	if (!(m_game.getBoard().containsCheckMate() || m_game.getState().isDraw())) {
+	    	if (!m_game.getState().isGameOver()) {
 				spawnThinkThread();
 			} else {
+				updateHints();
                 m_endgametimer = Timer(Timer::LINEAR);
                 m_endgametimer.setDuration(1.0);
                 m_endgametimer.start();
@@ -384,24 +416,28 @@ bool GameCore::handleEvent(SDL_Event& e)
 		else if (e.user.code == Menu::eSHADOWTOG) {
             m_options->shadows = !m_options->shadows;
 		}
+		else if (e.user.code == Menu::eHINTSTOG) {
+			m_options->hints = !m_options->hints;
+			updateHints();
+		}
 		else if (e.user.code == Menu::eHISTORYARROWSTOG) {
 			m_theme->toggleHistoryArrows();
 		}
 		else if (e.user.code == Menu::eBBRUTALPLYCHANGED) {
-			// Set the AI ply depth based on the ai difficulty string
+			// Set the AI budgets based on the ai difficulty string
 			string difficulty = m_blackbrutalplychoices->getCurrentChoice();
 			if (AI_DIFFICULTY_EASY == difficulty) {
-                m_options->brutalplayer2ply = EASY;
+				m_options->player2diff = EASY;
 			} 
 			else if (AI_DIFFICULTY_MEDIUM == difficulty) {
-				m_options->brutalplayer2ply = MEDIUM;
+				m_options->player2diff = MEDIUM;
 			} 
 			else if (AI_DIFFICULTY_HARD == difficulty) {
-				m_options->brutalplayer2ply = HARD;
+				m_options->player2diff = HARD;
 			}
 			BrutalPlayer* player = dynamic_cast<BrutalPlayer*>(m_game.getPlayer2());
 			if (player) {
-				player->setPly(m_options->brutalplayer2ply);
+				player->setDifficulty(m_options->player2diff);
 			}
 		}
 		else if (e.user.code == Menu::eBLACKPLAYERCHANGED) {
@@ -409,20 +445,20 @@ bool GameCore::handleEvent(SDL_Event& e)
 			m_blackbrutalplychoices->setCollapsed(PLAYER_BRUTAL != m_suggestedblackplayer);
 		}
 		else if (e.user.code == Menu::eWBRUTALPLYCHANGED) {
-			// Set the AI ply depth based on the ai difficulty string
+			// Set the AI budgets based on the ai difficulty string
 			string difficulty = m_whitebrutalplychoices->getCurrentChoice();
 			if (AI_DIFFICULTY_EASY == difficulty) {
-				m_options->brutalplayer1ply = EASY;
+				m_options->player1diff = EASY;
 			} 
 			else if (AI_DIFFICULTY_MEDIUM == difficulty) {
-				m_options->brutalplayer1ply = MEDIUM;
+				m_options->player1diff = MEDIUM;
 			} 
 			else if (AI_DIFFICULTY_HARD == difficulty) {
-				m_options->brutalplayer1ply = HARD;
+				m_options->player1diff = HARD;
 			}
 			BrutalPlayer* player = dynamic_cast<BrutalPlayer*>(m_game.getPlayer1());
 			if (player) {
-				player->setPly(m_options->brutalplayer1ply);
+				player->setDifficulty(m_options->player1diff);
 			}
 		}
 		else if (e.user.code == Menu::eWHITEPLAYERCHANGED) {
@@ -430,24 +466,23 @@ bool GameCore::handleEvent(SDL_Event& e)
 			m_whitebrutalplychoices->setCollapsed(PLAYER_BRUTAL != m_suggestedwhiteplayer);
 		}
 		else if (e.user.code == Menu::eSTARTNEWGAME) {
+			// The old players are about to be deleted
+			stopThinkThread();
 			ChessPlayer * whiteplayer = PlayerFactory(m_suggestedwhiteplayer);
 			BrutalPlayer* brutalplayer = dynamic_cast<BrutalPlayer*>(whiteplayer);
 			if (brutalplayer) {
-				brutalplayer->setPly(m_options->brutalplayer1ply);
+				brutalplayer->setDifficulty(m_options->player1diff);
 			}
 			whiteplayer->setIsWhite(true);
 			ChessPlayer * blackplayer = PlayerFactory(m_suggestedblackplayer);
 			brutalplayer = dynamic_cast<BrutalPlayer*>(blackplayer);
 			if (brutalplayer) {
-				brutalplayer->setPly(m_options->brutalplayer2ply);
+				brutalplayer->setDifficulty(m_options->player2diff);
 			}
 			blackplayer->setIsWhite(false);
 			m_game.setPlayer1(whiteplayer);
 			m_game.setPlayer2(blackplayer);
 			m_game.newGame();
-			if (m_thinkthread) {
-				SDL_KillThread(m_thinkthread);
-			}
 			spawnThinkThread();
 			SDL_Event backEvent;
 			backEvent.type = SDL_USEREVENT;
@@ -754,6 +789,7 @@ void GameCore::buildMenu()
 	m_menu.addMenuItem("New Game", new ActionItem("Back", Menu::eBACK));
     
 	// Game Options
+	m_menu.addMenuItem("Game Options", new ToggleItem("Hints", Menu::eHINTSTOG, m_options->hints));
     m_menu.addMenuItem("Game Options", new ToggleItem("History Arrows", Menu::eHISTORYARROWSTOG, m_options->historyarrows));
 	m_menu.addMenuItem("Game Options", new SeparatorItem());
 	m_menu.addMenuItem("Game Options", new ActionItem("Back", Menu::eBACK));
@@ -862,28 +898,40 @@ void GameCore::updateMouseBoardPos()
 	m_mousepos = BoardPosition((int)floor(x), -(int)ceil(z));
 }
 
-int callThink(void *pt)
+int GameCore::callThink(void *pt)
 {
-	ChessGame* game = (ChessGame*)pt;
+	GameCore * core = (GameCore*)pt;
+	ChessPlayer * player = core->m_thinkplayer;
+	int ticket = core->m_thinkcount;
+
 	// Give the player time to think
-	game->getCurrentPlayer()->think(game->getState());
+	player->think(core->m_game.getState());
+
+	// Whoever interrupted us is already waiting for the thread to finish
+	if(player->wasInterrupted()) {
+		return 0;
+	}
 
 	// Finished thinking, let the main thread know
 	SDL_Event thinkevent;
 	thinkevent.type = SDL_USEREVENT;
 	thinkevent.user.code = 0;
-	thinkevent.user.data1 = game->getCurrentPlayer();
-	thinkevent.user.data2 = NULL;
+	thinkevent.user.data1 = player;
+	thinkevent.user.data2 = (void*)(size_t)ticket;
 	SDL_PushEvent(&thinkevent);
 	return 0;
 }
 
 void GameCore::spawnThinkThread()
 {
-	m_thinkthread = SDL_CreateThread(callThink, &m_game);
+	m_thinkplayer = m_game.getCurrentPlayer();
+	m_thinkplayer->resetInterrupt();
+	m_thinkcount++;
+	m_thinkthread = SDL_CreateThread(callThink, this);
 	if(m_thinkthread == NULL) {
 		cerr << "Unable to create think thread: " << SDL_GetError() << endl;
 	}
+	updateHints();
 
 	/* 
 	if(!m_game.getCurrentPlayer()->isHuman()) {
@@ -892,6 +940,69 @@ void GameCore::spawnThinkThread()
 	*/
 }
 
+void GameCore::stopThinkThread()
+{
+	if(m_thinkthread) {
+		m_thinkplayer->interruptThinking();
+		SDL_WaitThread(m_thinkthread, NULL);
+		m_thinkthread = NULL;
+	}
+}
+
+BrutalPlayer * GameCore::hintEngine()
+{
+	BrutalPlayer * engine = dynamic_cast<BrutalPlayer*>(m_game.getInactivePlayer());
+	if(engine) {
+		return engine;
+	}
+	if(!m_hinter) {
+		m_hinter = new BrutalPlayer();
+	}
+	return m_hinter;
+}
+
+void GameCore::updateHints()
+{
+	ChessPlayer * player = m_game.getCurrentPlayer();
+	if(m_options->hints && m_thinkthread && player->isHuman()) {
+		hintEngine()->startAnalysis(m_game.getState());
+		return;
+	}
+
+	BrutalPlayer * engine = dynamic_cast<BrutalPlayer*>(m_game.getInactivePlayer());
+	if(engine) {
+		engine->stopAnalysis();
+	}
+	if(m_hinter) {
+		m_hinter->stopAnalysis();
+	}
+}
+
+void GameCore::drawHintText(int score, int depth)
+{
+	glLoadIdentity();
+	double height = static_cast<double>(m_options->getResolutionHeight());
+	double width = static_cast<double>(m_options->getResolutionWidth());
+	double aspectRatioDiff = (height/width)  - 0.75;
+	glTranslated(-40.0 + 50.0*aspectRatioDiff, -27.0, -106);
+
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_LIGHTING);
+	glEnable(GL_BLEND);
+	glColor4f(0.2, 1.0, 0.2, 0.8);
+	glScaled(1/10.0, 1/10.0, 1/10.0);
+	// Scores this big are mates or table wins, not pawns
+	if(abs(score) >= 10000) {
+		FontLoader::print(0, 0, "Hint: %s, depth %d", (score > 0) ? "winning" : "losing", depth);
+	} else {
+		FontLoader::print(0, 0, "Hint: %+.2f, depth %d", score / 100.0, depth);
+	}
+	glScaled(10, 10, 10);
+	glDisable(GL_BLEND);
+	glEnable(GL_LIGHTING);
+	glEnable(GL_DEPTH_TEST);
+}
+
 Piece::Type GameCore::getPromotionSelection(const BoardPosition & bp)
 {
 	if (m_game.getCurrentPlayer()->isWhite()) {
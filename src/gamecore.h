@@ -18,6 +18,7 @@
 #include "SDL_thread.h"
 #include "texture.h"
 
+class BrutalPlayer;
 class ChoicesItem;
 class Options;
 class ToggleItem;
@@ -105,6 +106,9 @@ class GameCore {
 		m_mousey(0),
 		m_mousepos(),
 		m_thinkthread(0),
+		m_thinkplayer(0),
+		m_thinkcount(0),
+		m_hinter(0),
 		m_rotate(false),
 		m_rotatex(0),
 		m_rotatey(0) {}
@@ -122,7 +126,38 @@ class GameCore {
 	SDL_Thread * m_thinkthread;
 	SDL_Thread * m_loadthread;
 
+	// The player the think thread is running for, and how many think
+	// threads have been started so notices from stopped ones are ignored
+	ChessPlayer * m_thinkplayer;
+	int m_thinkcount;
+
 	void spawnThinkThread();
+
+	/**
+	 * Interrupts the think thread, if there is one, and waits for it to
+	 * return. Players give control back within a few milliseconds.
+	 */
+	void stopThinkThread();
+
+	static int callThink(void * pt);
+
+	/**
+	 * Returns the player that analyses positions for hints: the opponent if
+	 * it is a BrutalPlayer, so it shares the work, otherwise one of our own.
+	 */
+	BrutalPlayer * hintEngine();
+
+	/**
+	 * Starts analysing the position for hints if a human is to move and
+	 * hints are on, otherwise stops any analysis.
+	 */
+	void updateHints();
+
+	/** Draws the hint's score and depth in the corner of the screen. */
+	void drawHintText(int score, int depth);
+
+	// Gives hints when the opponent can't, owned
+	BrutalPlayer * m_hinter;
 	
 	BoardTheme * m_theme; 
 	PieceSet * m_set;
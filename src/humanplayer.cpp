@@ -23,7 +23,7 @@ HumanPlayer::HumanPlayer()
 void HumanPlayer::think(const ChessGameState & cgs)
 {
 	m_move.invalidate();
-	while(!m_move.isValid())
+	while(!m_move.isValid() && !m_interrupted)
 	{
 		SDL_Delay(50);
 	}
@@ -0,0 +1,103 @@
+/***************************************************************************
+ * Brutal Chess
+ * http://brutalchess.sf.net
+ *
+ * File : mappedfile.cpp
+ * Authors : Mike Cook, Joe Flint, Neil Pankey
+ **************************************************************************/
+
+#include "mappedfile.h"
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+MappedFile::MappedFile() :
+	m_data(0),
+	m_size(0)
+#ifdef WIN32
+	, m_file(INVALID_HANDLE_VALUE),
+	m_mapping(NULL)
+#else
+	, m_fd(-1)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(const string & filename)
+{
+	close();
+
+#ifdef WIN32
+	m_file = CreateFile(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+	                    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if(m_file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	m_size = GetFileSize(m_file, NULL);
+	if(m_size > 0) {
+		m_mapping = CreateFileMapping(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if(m_mapping != NULL) {
+			m_data = (const unsigned char*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+		}
+	}
+#else
+	m_fd = ::open(filename.c_str(), O_RDONLY);
+	if(m_fd < 0) {
+		return false;
+	}
+	struct stat st;
+	if(fstat(m_fd, &st) == 0 && st.st_size > 0) {
+		m_size = st.st_size;
+		void * data = mmap(NULL, m_size, PROT_READ, MAP_SHARED, m_fd, 0);
+		if(data != MAP_FAILED) {
+			m_data = (const unsigned char*)data;
+		}
+	}
+#endif
+
+	if(!m_data) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::close()
+{
+#ifdef WIN32
+	if(m_data) {
+		UnmapViewOfFile(m_data);
+	}
+	if(m_mapping != NULL) {
+		CloseHandle(m_mapping);
+		m_mapping = NULL;
+	}
+	if(m_file != INVALID_HANDLE_VALUE) {
+		CloseHandle(m_file);
+		m_file = INVALID_HANDLE_VALUE;
+	}
+#else
+	if(m_data) {
+		munmap((void*)m_data, m_size);
+	}
+	if(m_fd >= 0) {
+		::close(m_fd);
+		m_fd = -1;
+	}
+#endif
+	m_data = 0;
+	m_size = 0;
+}
+
+// End of file mappedfile.cpp
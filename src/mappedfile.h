@@ -0,0 +1,67 @@
+/***************************************************************************
+ * Brutal Chess
+ * http://brutalchess.sf.net
+ *
+ * File : mappedfile.h
+ * Authors : Mike Cook, Joe Flint, Neil Pankey
+ **************************************************************************/
+
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+#ifdef WIN32
+#include <windows.h>
+#endif
+
+/**
+ * A file mapped read only into memory. The pages are shared with every
+ * other process mapping the same file and are only read in from disk as
+ * they are touched.
+ */
+class MappedFile {
+ public:
+	MappedFile();
+
+	~MappedFile();
+
+	/**
+	 * Maps the named file, closing whatever was mapped before. Returns
+	 * false, leaving nothing mapped, if the file can't be opened or is
+	 * empty.
+	 */
+	bool open(const std::string & filename);
+
+	/** Unmaps the file. */
+	void close();
+
+	bool isOpen() const
+		{ return m_data != 0; }
+
+	const unsigned char * data() const
+		{ return m_data; }
+
+	size_t size() const
+		{ return m_size; }
+
+ private:
+	const unsigned char * m_data;
+	size_t m_size;
+
+#ifdef WIN32
+	HANDLE m_file;
+	HANDLE m_mapping;
+#else
+	int m_fd;
+#endif
+
+	// Mappings are shared, not copied
+	MappedFile(const MappedFile &);
+	MappedFile & operator=(const MappedFile &);
+};
+
+#endif
+
+// End of file mappedfile.h
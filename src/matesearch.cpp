@@ -0,0 +1,232 @@
+/***************************************************************************
+ * Brutal Chess
+ * http://brutalchess.sf.net
+ *
+ * File : matesearch.cpp
+ * Authors : Mike Cook, Joe Flint, Neil Pankey
+ **************************************************************************/
+
+#include "matesearch.h"
+
+using namespace std;
+
+// Proof and disproof numbers of a settled position
+static const int INFINITE = 100000000;
+
+static const int ENTRY_SIZE = 16;
+
+// Adds proof numbers without running past infinity
+static int addNumbers(int a, int b)
+{
+	return (a >= INFINITE - b) ? INFINITE : a + b;
+}
+
+MateSearch::MateSearch(int megabytes) :
+	m_best(-1),
+	m_nodes(0),
+	m_maxnodes(DEFAULT_NODES),
+	m_stop(0),
+	m_aborted(false)
+{
+	size_t entries = 1;
+	while(entries * 2 * ENTRY_SIZE <= (size_t)megabytes * 1024 * 1024) {
+		entries *= 2;
+	}
+	m_table.resize(entries);
+	m_mask = entries - 1;
+	clear();
+
+	// Any fixed, well mixed numbers will do
+	unsigned long long seed = 0x9E3779B97F4A7C15ULL;
+	for(int i = 0; i <= MAX_PLIES; i++) {
+		seed ^= seed << 13;
+		seed ^= seed >> 7;
+		seed ^= seed << 17;
+		m_remainingkeys[i] = seed;
+	}
+}
+
+void MateSearch::clear()
+{
+	for(size_t i = 0; i < m_table.size(); i++) {
+		m_table[i].key = 0;
+		m_table[i].phi = 1;
+		m_table[i].delta = 1;
+	}
+}
+
+bool MateSearch::findMate(const Board & board, Piece::Color c, int moves, BoardMove & move,
+                          const volatile bool * stop)
+{
+	m_nodes = 0;
+	m_stop = stop;
+	m_aborted = false;
+
+	if(moves < 1 || moves > MAX_MATE) {
+		return false;
+	}
+
+	int remaining = 2*moves - 1;
+	unsigned long long rootkey = key(board, c, remaining);
+	m_stack[0] = board;
+	m_best = -1;
+	mid(0, c, remaining, rootkey, INFINITE, INFINITE);
+
+	int phi, delta;
+	lookup(rootkey, phi, delta);
+	if(m_aborted || phi != 0 || m_best < 0) {
+		return false;
+	}
+	move = m_moves[0][m_best];
+	return true;
+}
+
+int MateSearch::mateIn(const Board & board, Piece::Color c, int maxmoves, BoardMove & move,
+                       const volatile bool * stop)
+{
+	// Each length is cheap next to the one after it, so trying them in
+	// turn finds the quickest mate for little more than the cost of one
+	unsigned long total = 0, limit = m_maxnodes;
+	int found = 0;
+	for(int moves = 1; moves <= maxmoves && moves <= MAX_MATE && total < limit; moves++) {
+		m_maxnodes = limit - total;
+		bool mate = findMate(board, c, moves, move, stop);
+		total += m_nodes;
+		if(mate) {
+			found = moves;
+			break;
+		}
+		if(m_aborted) {
+			break;
+		}
+	}
+	m_maxnodes = limit;
+	m_nodes = total;
+	return found;
+}
+
+void MateSearch::mid(int ply, Piece::Color c, int remaining, unsigned long long nodekey, int thphi, int thdelta)
+{
+	int phi, delta;
+	lookup(nodekey, phi, delta);
+	if(phi >= thphi || delta >= thdelta) {
+		return;
+	}
+
+	m_nodes++;
+	if(m_nodes > m_maxnodes || (m_stop && *m_stop)) {
+		m_aborted = true;
+		return;
+	}
+
+	const Board & board = m_stack[ply];
+	bool attacker = (remaining % 2) == 1;
+
+	// Out of checks, or mated, or stalemated
+	int count = expand(ply, c, remaining);
+	if(count == 0) {
+		if(attacker || board.isCheck(c)) {
+			store(nodekey, INFINITE, 0);
+		} else {
+			store(nodekey, 0, INFINITE);
+		}
+		return;
+	}
+
+	// The defender survived every check there was time for
+	if(remaining == 0) {
+		store(nodekey, 0, INFINITE);
+		return;
+	}
+
+	Piece::Color opponent = Piece::opposite(c);
+	for(;;) {
+		// A position is as easy to win as its easiest move, and as hard to
+		// lose as all of its moves together
+		int best = 0, bestphi = 0, bestdelta = INFINITE, second = INFINITE;
+		phi = INFINITE;
+		delta = 0;
+		for(int i = 0; i < count; i++) {
+			int cphi, cdelta;
+			lookup(m_keys[ply][i], cphi, cdelta);
+			delta = addNumbers(delta, cphi);
+			if(cdelta < bestdelta) {
+				second = bestdelta;
+				bestdelta = cdelta;
+				bestphi = cphi;
+				best = i;
+			} else if(cdelta < second) {
+				second = cdelta;
+			}
+		}
+		phi = bestdelta;
+		if(ply == 0) {
+			m_best = best;
+		}
+
+		if(phi >= thphi || delta >= thdelta) {
+			store(nodekey, phi, delta);
+			return;
+		}
+
+		// Search the best move until it stops being the best
+		m_stack[ply+1] = board;
+		m_stack[ply+1].update(m_moves[ply][best]);
+		int childphi = (thdelta >= INFINITE) ? INFINITE : thdelta + bestphi - delta;
+		int childdelta = (second >= INFINITE) ? thphi : min(thphi, second + 1);
+		mid(ply+1, opponent, remaining-1, m_keys[ply][best], childphi, childdelta);
+		if(m_aborted) {
+			return;
+		}
+	}
+}
+
+int MateSearch::expand(int ply, Piece::Color c, int remaining)
+{
+	const Board & board = m_stack[ply];
+	Piece::Color opponent = Piece::opposite(c);
+	bool attacker = (remaining % 2) == 1;
+	BoardMove * moves = m_moves[ply];
+
+	int count = 0;
+	int total = board.generateMoves(c, moves);
+	for(int i = 0; i < total; i++) {
+		Board & child = m_stack[ply+1];
+		child = board;
+		child.update(moves[i]);
+		if(child.isCheck(c) || (attacker && !child.isCheck(opponent))) {
+			continue;
+		}
+		moves[count] = moves[i];
+		m_keys[ply][count] = key(child, opponent, remaining > 0 ? remaining - 1 : 0);
+		count++;
+
+		// With no time left the defender only has to have a move
+		if(remaining == 0) {
+			break;
+		}
+	}
+	return count;
+}
+
+void MateSearch::lookup(unsigned long long key, int & phi, int & delta) const
+{
+	const Entry & entry = m_table[key & m_mask];
+	if(entry.key == key) {
+		phi = entry.phi;
+		delta = entry.delta;
+	} else {
+		phi = 1;
+		delta = 1;
+	}
+}
+
+void MateSearch::store(unsigned long long key, int phi, int delta)
+{
+	Entry & entry = m_table[key & m_mask];
+	entry.key = key;
+	entry.phi = phi;
+	entry.delta = delta;
+}
+
+// End of file matesearch.cpp
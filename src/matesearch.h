@@ -0,0 +1,126 @@
+/***************************************************************************
+ * Brutal Chess
+ * http://brutalchess.sf.net
+ *
+ * File : matesearch.h
+ * Authors : Mike Cook, Joe Flint, Neil Pankey
+ **************************************************************************/
+
+#ifndef MATESEARCH_H
+#define MATESEARCH_H
+
+#include "board.h"
+#include "boardmove.h"
+
+#include <vector>
+
+/**
+ * Finds forced mates with a depth-first proof-number search. Only checks
+ * are tried for the side giving mate and every legal reply for the side
+ * being mated, and the search always expands the position that is
+ * cheapest to prove or disprove, so it reaches mates far deeper than a
+ * full width alpha-beta search of the same size.
+ *
+ * Positions are kept in a table keyed on their hash key and the number
+ * of plies left, so results carry over between searches of the same game.
+ */
+class MateSearch {
+ public:
+	/**
+	 * Creates a search with a table of about the given size.
+	 * @param megabytes - Memory to use, rounded down to a power of two entries.
+	 */
+	MateSearch(int megabytes = DEFAULT_SIZE);
+
+	/**
+	 * Looks for a mate by color c in at most moves moves. Returns true
+	 * with the mating move in move if one is proven. A mate is only
+	 * guaranteed to be found if it is there and the node limit isn't hit
+	 * first, and it needn't be the quickest.
+	 * @param stop - Set by another thread to give up early, may be 0.
+	 */
+	bool findMate(const Board & board, Piece::Color c, int moves, BoardMove & move,
+	              const volatile bool * stop = 0);
+
+	/**
+	 * Finds the quickest mate by color c in at most maxmoves moves, for
+	 * analysis. Returns the number of moves to mate, with the first of
+	 * them in move, or 0 if no mate was found.
+	 * @param stop - Set by another thread to give up early, may be 0.
+	 */
+	int mateIn(const Board & board, Piece::Color c, int maxmoves, BoardMove & move,
+	           const volatile bool * stop = 0);
+
+	/** Limits how many nodes one call to findMate or mateIn may visit. */
+	void setMaxNodes(unsigned long nodes)
+		{ m_maxnodes = nodes; }
+
+	/** Nodes visited by the last findMate or mateIn */
+	unsigned long nodes() const
+		{ return m_nodes; }
+
+	/** Forgets every position searched. */
+	void clear();
+
+	/** Default table size in megabytes */
+	static const int DEFAULT_SIZE = 8;
+
+	/** Default limit on nodes per search */
+	static const unsigned long DEFAULT_NODES = 200000;
+
+	/** Longest mate, in moves, that can be searched for */
+	static const int MAX_MATE = 16;
+
+ private:
+	/** Proof and disproof numbers, seen from the side to move. */
+	struct Entry {
+		unsigned long long key;
+		int phi;
+		int delta;
+	};
+
+	static const int MAX_PLIES = 2*MAX_MATE;
+
+	/**
+	 * Searches the position at ply until its numbers pass one of the
+	 * thresholds. phi is the cost of proving the position a win for the
+	 * side to move, delta the cost of proving it a loss.
+	 */
+	void mid(int ply, Piece::Color c, int remaining, unsigned long long key, int thphi, int thdelta);
+
+	/**
+	 * Fills in the moves tried at ply, checks for the attacker and every
+	 * legal move for the defender, and the keys of where they lead.
+	 */
+	int expand(int ply, Piece::Color c, int remaining);
+
+	unsigned long long key(const Board & board, Piece::Color c, int remaining) const
+		{ return board.hashKey(c) ^ m_remainingkeys[remaining]; }
+
+	void lookup(unsigned long long key, int & phi, int & delta) const;
+
+	void store(unsigned long long key, int phi, int delta);
+
+	std::vector<Entry> m_table;
+	size_t m_mask;
+
+	// Salts the keys with the plies left, a position with more time left
+	// may be a mate where the same one with less isn't
+	unsigned long long m_remainingkeys[MAX_PLIES + 1];
+
+	Board m_stack[MAX_PLIES + 1];
+	BoardMove m_moves[MAX_PLIES][Board::MAX_MOVES];
+	unsigned long long m_keys[MAX_PLIES][Board::MAX_MOVES];
+
+	// The root move being worked on, the mating move once proven
+	int m_best;
+
+	unsigned long m_nodes;
+	unsigned long m_maxnodes;
+	const volatile bool * m_stop;
+	bool m_aborted;
+};
+
+#endif
+
+// End of file matesearch.h
@@ -74,6 +74,7 @@ class Menu {
         eBBRUTALPLYCHANGED,
         eBLACKPLAYERCHANGED,
         eFULLSCREENTOG,
+        eHINTSTOG,
         eHISTORYARROWSTOG,
 		eQUIT,
         eREFLECTTOG,
@@ -0,0 +1,275 @@
+/***************************************************************************
+ * Brutal Chess
+ * http://brutalchess.sf.net
+ *
+ * File : network.cpp
+ * Authors : Mike Cook, Joe Flint, Neil Pankey
+ **************************************************************************/
+
+#include "network.h"
+#include "mappedfile.h"
+#include "options.h"
+
+#include <cstring>
+#include <iostream>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+Network * Network::m_instance = 0;
+
+// Size of the header before the weights
+static const int HEADER_SIZE = 12;
+
+// Adds a row of first layer weights to a side's sums
+static inline void addRow(short * acc, const short * row)
+{
+#if defined(__AVX2__)
+	for(int i = 0; i < Network::HIDDEN; i += 16) {
+		__m256i a = _mm256_loadu_si256((const __m256i*)(acc + i));
+		__m256i w = _mm256_loadu_si256((const __m256i*)(row + i));
+		_mm256_storeu_si256((__m256i*)(acc + i), _mm256_add_epi16(a, w));
+	}
+#elif defined(__SSE2__)
+	for(int i = 0; i < Network::HIDDEN; i += 8) {
+		__m128i a = _mm_loadu_si128((const __m128i*)(acc + i));
+		__m128i w = _mm_loadu_si128((const __m128i*)(row + i));
+		_mm_storeu_si128((__m128i*)(acc + i), _mm_add_epi16(a, w));
+	}
+#else
+	for(int i = 0; i < Network::HIDDEN; i++) {
+		acc[i] += row[i];
+	}
+#endif
+}
+
+// Takes a row of first layer weights away from a side's sums
+static inline void subRow(short * acc, const short * row)
+{
+#if defined(__AVX2__)
+	for(int i = 0; i < Network::HIDDEN; i += 16) {
+		__m256i a = _mm256_loadu_si256((const __m256i*)(acc + i));
+		__m256i w = _mm256_loadu_si256((const __m256i*)(row + i));
+		_mm256_storeu_si256((__m256i*)(acc + i), _mm256_sub_epi16(a, w));
+	}
+#elif defined(__SSE2__)
+	for(int i = 0; i < Network::HIDDEN; i += 8) {
+		__m128i a = _mm_loadu_si128((const __m128i*)(acc + i));
+		__m128i w = _mm_loadu_si128((const __m128i*)(row + i));
+		_mm_storeu_si128((__m128i*)(acc + i), _mm_sub_epi16(a, w));
+	}
+#else
+	for(int i = 0; i < Network::HIDDEN; i++) {
+		acc[i] -= row[i];
+	}
+#endif
+}
+
+// Clips a side's sums to 0..QA and returns their dot product with its half
+// of the output weights
+static inline int outputSum(const short * acc, const short * weights)
+{
+#if defined(__AVX2__)
+	__m256i zero = _mm256_setzero_si256();
+	__m256i top = _mm256_set1_epi16(Network::QA);
+	__m256i sum = _mm256_setzero_si256();
+	for(int i = 0; i < Network::HIDDEN; i += 16) {
+		__m256i a = _mm256_loadu_si256((const __m256i*)(acc + i));
+		__m256i w = _mm256_loadu_si256((const __m256i*)(weights + i));
+		a = _mm256_max_epi16(_mm256_min_epi16(a, top), zero);
+		sum = _mm256_add_epi32(sum, _mm256_madd_epi16(a, w));
+	}
+	__m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+	half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+	half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+	return _mm_cvtsi128_si32(half);
+#elif defined(__SSE2__)
+	__m128i zero = _mm_setzero_si128();
+	__m128i top = _mm_set1_epi16(Network::QA);
+	__m128i sum = _mm_setzero_si128();
+	for(int i = 0; i < Network::HIDDEN; i += 8) {
+		__m128i a = _mm_loadu_si128((const __m128i*)(acc + i));
+		__m128i w = _mm_loadu_si128((const __m128i*)(weights + i));
+		a = _mm_max_epi16(_mm_min_epi16(a, top), zero);
+		sum = _mm_add_epi32(sum, _mm_madd_epi16(a, w));
+	}
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+	return _mm_cvtsi128_si32(sum);
+#else
+	int sum = 0;
+	for(int i = 0; i < Network::HIDDEN; i++) {
+		int a = acc[i];
+		a = (a < 0) ? 0 : (a > Network::QA) ? Network::QA : a;
+		sum += a * weights[i];
+	}
+	return sum;
+#endif
+}
+
+// Reads a little endian number from the weights file
+static int readInt(const unsigned char * p, int bytes)
+{
+	unsigned int value = 0;
+	for(int i = bytes - 1; i >= 0; i--) {
+		value = (value << 8) | p[i];
+	}
+	return (bytes == 2) ? (int)(short)value : (int)value;
+}
+
+Network * Network::getInstance()
+{
+	if(m_instance == 0) {
+		m_instance = new Network();
+		Options * opts = Options::getInstance();
+		if(!opts->netfile.empty()) {
+			m_instance->load(opts->netfile);
+		}
+	}
+	return m_instance;
+}
+
+Network::Network() :
+	m_outbias(0),
+	m_loaded(false)
+{
+	m_weights = new short[INPUTS * HIDDEN];
+	m_biases = new short[HIDDEN];
+	m_output = new short[2 * HIDDEN];
+}
+
+Network::~Network()
+{
+	delete [] m_weights;
+	delete [] m_biases;
+	delete [] m_output;
+}
+
+bool Network::load(const string & filename)
+{
+	m_loaded = false;
+
+	MappedFile file;
+	if(!file.open(filename)) {
+		cerr << "Unable to read network weights " << filename << endl;
+		return false;
+	}
+
+	size_t expected = HEADER_SIZE + 2*(INPUTS*HIDDEN + HIDDEN + 2*HIDDEN) + 4;
+	const unsigned char * p = file.data();
+	if(file.size() != expected || memcmp(p, "BCNN", 4) != 0 ||
+	   readInt(p + 4, 4) != VERSION || readInt(p + 8, 4) != HIDDEN) {
+		cerr << "The network weights in " << filename << " aren't for a " << INPUTS;
+		cerr << "x" << HIDDEN << " network of version " << VERSION << endl;
+		return false;
+	}
+
+	p += HEADER_SIZE;
+	for(int i = 0; i < INPUTS * HIDDEN; i++, p += 2) {
+		m_weights[i] = (short)readInt(p, 2);
+	}
+	for(int i = 0; i < HIDDEN; i++, p += 2) {
+		m_biases[i] = (short)readInt(p, 2);
+	}
+	for(int i = 0; i < 2 * HIDDEN; i++, p += 2) {
+		m_output[i] = (short)readInt(p, 2);
+	}
+	m_outbias = readInt(p, 4);
+
+	m_loaded = true;
+	return true;
+}
+
+void Network::refresh(const Board & board, Accumulator & acc) const
+{
+	for(int side = 0; side <= Piece::LAST_COLOR; side++) {
+		memcpy(acc.values[side], m_biases, sizeof(acc.values[side]));
+	}
+
+	for(int c = 0; c <= Piece::LAST_COLOR; c++) {
+		for(int t = 0; t <= Piece::LAST_TYPE; t++) {
+			unsigned long long pieces = board.m_pieces[t] & board.m_color[c];
+			for(; pieces; pieces &= pieces - 1) {
+				int sq = bitScanForward(pieces);
+				addRow(acc.values[Piece::WHITE], weights(Piece::WHITE, Piece::Color(c), t, sq));
+				addRow(acc.values[Piece::BLACK], weights(Piece::BLACK, Piece::Color(c), t, sq));
+			}
+		}
+	}
+	acc.key = board.m_hash;
+}
+
+void Network::update(const Board & parent, const Board & child, const Accumulator & from,
+                     Accumulator & to) const
+{
+	memcpy(to.values, from.values, sizeof(to.values));
+
+	// A move changes two to four squares, whatever kind of move it was
+	for(int c = 0; c <= Piece::LAST_COLOR; c++) {
+		for(int t = 0; t <= Piece::LAST_TYPE; t++) {
+			unsigned long long before = parent.m_pieces[t] & parent.m_color[c];
+			unsigned long long after = child.m_pieces[t] & child.m_color[c];
+			if(before == after) {
+				continue;
+			}
+			for(unsigned long long gone = before & ~after; gone; gone &= gone - 1) {
+				int sq = bitScanForward(gone);
+				subRow(to.values[Piece::WHITE], weights(Piece::WHITE, Piece::Color(c), t, sq));
+				subRow(to.values[Piece::BLACK], weights(Piece::BLACK, Piece::Color(c), t, sq));
+			}
+			for(unsigned long long added = after & ~before; added; added &= added - 1) {
+				int sq = bitScanForward(added);
+				addRow(to.values[Piece::WHITE], weights(Piece::WHITE, Piece::Color(c), t, sq));
+				addRow(to.values[Piece::BLACK], weights(Piece::BLACK, Piece::Color(c), t, sq));
+			}
+		}
+	}
+	to.key = child.m_hash;
+}
+
+int Network::evaluate(const Accumulator & acc, Piece::Color turn) const
+{
+	int sum = outputSum(acc.values[turn], m_output) +
+	          outputSum(acc.values[Piece::opposite(turn)], m_output + HIDDEN) + m_outbias;
+	return (int)((long long)sum * SCALE / (QA * QB));
+}
+
+void Network::evaluateBatch(const Board * boards, int n, int * out,
+                            const Piece::Color * turns) const
+{
+	Accumulator accs[2];
+	Accumulator * last = &accs[0], * acc = &accs[1];
+
+	for(int i = 0; i < n; i++) {
+		const Board & board = boards[i];
+
+		// Updating costs a row per changed piece, refreshing one per piece
+		int changes = 0;
+		if(i > 0) {
+			const Board & prev = boards[i-1];
+			for(int c = 0; c <= Piece::LAST_COLOR; c++) {
+				for(int t = 0; t <= Piece::LAST_TYPE; t++) {
+					changes += popCount((prev.m_pieces[t] & prev.m_color[c]) ^
+					                    (board.m_pieces[t] & board.m_color[c]));
+				}
+			}
+		}
+		if(i > 0 && changes < popCount(board.m_color[Piece::WHITE] | board.m_color[Piece::BLACK])) {
+			update(boards[i-1], board, *last, *acc);
+		} else {
+			refresh(board, *acc);
+		}
+
+		out[i] = evaluate(*acc, turns ? turns[i] : Piece::WHITE);
+		Accumulator * swap = last;
+		last = acc;
+		acc = swap;
+	}
+}
+
+// End of file network.cpp
@@ -0,0 +1,124 @@
+/***************************************************************************
+ * Brutal Chess
+ * http://brutalchess.sf.net
+ *
+ * File : network.h
+ * Authors : Mike Cook, Joe Flint, Neil Pankey
+ **************************************************************************/
+
+#ifndef NETWORK_H
+#define NETWORK_H
+
+#include "board.h"
+#include "piece.h"
+
+#include <string>
+
+/**
+ * An efficiently updatable neural network evaluation. Its 768 inputs
+ * are one for each piece type of each color on each square. They feed a
+ * layer of HIDDEN neurons, which is worked out twice, once from each
+ * side's point of view with the board turned over for black. The side to
+ * move's half and the other half are clipped to 0..QA and go through one
+ * output neuron to give the score.
+ *
+ * Only a few inputs change with a move, so the first layer sums, the
+ * Accumulator, are carried from a board to the next by adding and taking
+ * away the weights of the pieces that moved rather than being summed
+ * from scratch. The sums are 16 bit integers and are added and run
+ * through the output layer 16 or 8 at a time with AVX2 or SSE2, when the
+ * compiler is allowed to use them, or one at a time without.
+ *
+ * A weights file is, all numbers little endian:
+ *   "BCNN", then the version and HIDDEN as 32 bit integers,
+ *   the 16 bit first layer weights, HIDDEN for each input in turn,
+ *   the HIDDEN 16 bit first layer biases,
+ *   the 2*HIDDEN 16 bit output weights, the side to move's half first,
+ *   and the 32 bit output bias.
+ * The first layer is scaled by QA and the output weights by QB, so the
+ * output divided by QA*QB is the score in units of SCALE centipawns.
+ */
+class Network {
+ public:
+	/** Neurons in the first layer, for each side */
+	static const int HIDDEN = 256;
+
+	/** Inputs, one for each piece of each color on each square */
+	static const int INPUTS = 768;
+
+	/** Scales of the first and output layer weights */
+	static const int QA = 255;
+	static const int QB = 64;
+
+	/** Centipawns an output of 1.0 is worth */
+	static const int SCALE = 400;
+
+	/** Version of the weights file layout */
+	static const int VERSION = 1;
+
+	/** The first layer sums of one board, from each side's point of view. */
+	struct Accumulator {
+		short values[Piece::LAST_COLOR + 1][HIDDEN];
+
+		/** Piece key of the board the sums are for, 0 if none */
+		unsigned long long key;
+	};
+
+	/** Returns the network in the file named in the Options. */
+	static Network * getInstance();
+
+	Network();
+
+	~Network();
+
+	/** Reads the weights from filename, returning false if they aren't valid. */
+	bool load(const std::string & filename);
+
+	/** Returns true once weights have been loaded. */
+	bool isLoaded() const
+		{ return m_loaded; }
+
+	/** Sums the first layer of board from scratch. */
+	void refresh(const Board & board, Accumulator & acc) const;
+
+	/**
+	 * Works out the sums of child from those of parent, only looking at the
+	 * squares whose pieces differ between the two.
+	 */
+	void update(const Board & parent, const Board & child, const Accumulator & from,
+	            Accumulator & to) const;
+
+	/** Returns the score of the board acc was summed for, for the side to move. */
+	int evaluate(const Accumulator & acc, Piece::Color turn) const;
+
+	/**
+	 * Scores n boards into out, each for the side to move given in turns,
+	 * or for white if turns is 0. Boards next to each other that differ by
+	 * a few pieces, like positions from one game, are summed from the one
+	 * before rather than from scratch.
+	 */
+	void evaluateBatch(const Board * boards, int n, int * out,
+	                   const Piece::Color * turns = 0) const;
+
+ private:
+	/** Row of first layer weights of a piece, from the given side's point of view */
+	const short * weights(Piece::Color side, Piece::Color c, int type, int sq) const
+		{ return m_weights + HIDDEN * ((c == side ? 0 : 384) + 64*type +
+		                               (side == Piece::WHITE ? sq : sq ^ 56)); }
+
+	short * m_weights;
+	short * m_biases;
+	short * m_output;
+	int m_outbias;
+	bool m_loaded;
+
+	static Network * m_instance;
+
+	// Networks are shared, not copied
+	Network(const Network &);
+	Network & operator=(const Network &);
+};
+
+#endif
+
+// End of file network.h
@@ -0,0 +1,86 @@
+/***************************************************************************
+ * Brutal Chess
+ * http://brutalchess.sf.net
+ *
+ * File : openingbook.h
+ * Authors : Mike Cook, Joe Flint, Neil Pankey
+ **************************************************************************/
+
+#ifndef OPENINGBOOK_H
+#define OPENINGBOOK_H
+
+#include "board.h"
+#include "boardmove.h"
+#include "mappedfile.h"
+
+#include <string>
+
+/**
+ * An opening book in the Polyglot .bin format. The file is memory mapped
+ * read only, so every process using the same book shares its pages, and
+ * a position is looked up by binary search on its Polyglot key.
+ */
+class OpeningBook {
+ public:
+	/** Returns the book named in the Options, opening it on first use. */
+	static OpeningBook * getInstance();
+
+	OpeningBook();
+
+	~OpeningBook();
+
+	/**
+	 * Maps the book into memory. Returns false, leaving the book closed, if
+	 * the file can't be read.
+	 * @param bookfile - The .bin book.
+	 */
+	bool open(const std::string & bookfile);
+
+	/** Unmaps the book. */
+	void close();
+
+	bool isOpen() const
+		{ return m_file.isOpen(); }
+
+	/** Returns the Polyglot key of board with color c to move. */
+	unsigned long long key(const Board & board, Piece::Color c) const;
+
+	/**
+	 * Picks one of the book moves for the position at random, weighted by
+	 * the weights in the book. Returns an invalid move if the position
+	 * isn't in the book.
+	 */
+	BoardMove probe(const Board & board, Piece::Color c) const;
+
+	/**
+	 * Fills moves and weights with every legal book move for the position,
+	 * returning how many there are, at most max.
+	 */
+	int getMoves(const Board & board, Piece::Color c, BoardMove * moves, int * weights, int max) const;
+
+ private:
+	/** Size in bytes of a book entry */
+	static const int ENTRY_SIZE = 16;
+
+	/** Reads a big endian number of the given size at the given entry. */
+	unsigned long long read(size_t entry, int offset, int bytes) const;
+
+	/** Returns the first entry whose key is not less than key. */
+	size_t lowerBound(unsigned long long key) const;
+
+	/** Turns a Polyglot move into a BoardMove on board. */
+	BoardMove decodeMove(int move, const Board & board) const;
+
+	MappedFile m_file;
+	size_t m_entries;
+
+	static OpeningBook * m_instance;
+
+	// Books are shared, not copied
+	OpeningBook(const OpeningBook &);
+	OpeningBook & operator=(const OpeningBook &);
+};
+
+#endif
+
+// End of file openingbook.h
@@ -33,8 +33,22 @@ Options::Options()
 	player2 = BRUTAL;
 	player2diff = MEDIUM;
 	resolution = r800X600;
-	brutalplayer1ply = DEFAULT_PLY_DEPTH;
-	brutalplayer2ply = DEFAULT_PLY_DEPTH;
+	profiles[EASY].nodes = 3000;
+	profiles[EASY].movetime = 250;
+	profiles[EASY].noise = 60;
+	profiles[MEDIUM].nodes = 30000;
+	profiles[MEDIUM].movetime = 750;
+	profiles[MEDIUM].noise = 15;
+	profiles[HARD].nodes = 400000;
+	profiles[HARD].movetime = 2500;
+	profiles[HARD].noise = 0;
+	searchthreads = 1;
+	ponder = false;
+	bookfile = "../books/book.bin";
+	egtbpath = "../egtb";
+	netfile = "";
+	matesearch = 0;
+	hints = false;
 
 	// Initialize the enum maps
 	m_boardTypeString[GRANITE] = "Granite";
@@ -15,9 +15,25 @@
 enum BoardType {GRANITE, WOOD};
 enum PiecesType {BASIC, DEBUG, QUAKE};
 enum PlayerType {BRUTAL, FAILE, HUMAN, RANDOM, TEST, XBOARD};
-enum Difficulty {EASY=2, MEDIUM=3, HARD=4};
+enum Difficulty {EASY, MEDIUM, HARD};
 
-#define DEFAULT_PLY_DEPTH MEDIUM
+#define DEFAULT_PLY_DEPTH 3
+
+/**
+ * What the Brutal AI may spend on a move at a difficulty. It searches as
+ * deep as the budgets let it, so a level plays about as well, and as
+ * quickly, in every position.
+ */
+struct DifficultyProfile {
+	// Nodes the main search thread may visit, 0 for no limit
+	unsigned long nodes;
+
+	// Longest the AI thinks, in ms
+	unsigned int movetime;
+
+	// Most centipawns of error added to each evaluation, 0 for none
+	int noise;
+};
 
 // Keep things synced between menu events and this
 enum Resolution {r640X480, r800X600, r1024X768, r1280X1024, r1400X1050, r1600X1200, };
@@ -33,8 +49,30 @@ class Options {
 	PlayerType player1, player2;
 	Resolution resolution;
 
-	// Won't need eventually
-	int brutalplayer1ply, brutalplayer2ply;
+	// Budgets of the Brutal AI at each difficulty
+	DifficultyProfile profiles[HARD + 1];
+
+	// Number of threads each BrutalPlayer searches with
+	int searchthreads;
+
+	// Whether BrutalPlayers think on their opponent's time
+	bool ponder;
+
+	// Polyglot opening book
+	std::string bookfile;
+
+	// Directory holding the endgame tables
+	std::string egtbpath;
+
+	// Weights of the neural network evaluation, empty to use the
+	// hand-written one
+	std::string netfile;
+
+	// Longest forced mate, in moves, BrutalPlayers look for before searching
+	int matesearch;
+
+	// Whether human players are shown the move the Brutal AI would play
+	bool hints;
 
     std::string getBoardString() 
 		{ return m_boardTypeString[board]; }
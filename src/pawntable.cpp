@@ -0,0 +1,40 @@
+/***************************************************************************
+ * Brutal Chess
+ * http://brutalchess.sf.net
+ *
+ * File : pawntable.cpp
+ * Authors : Mike Cook, Joe Flint, Neil Pankey
+ **************************************************************************/
+
+#include "pawntable.h"
+
+#include <cstring>
+
+PawnTable::PawnTable(int kilobytes)
+{
+	if(kilobytes < 1) {
+		kilobytes = 1;
+	}
+
+	unsigned long long count = 1;
+	while(2 * count * sizeof(Entry) <= (unsigned long long)kilobytes << 10) {
+		count *= 2;
+	}
+
+	m_entries = new Entry[count];
+	m_mask = count - 1;
+	clear();
+}
+
+PawnTable::~PawnTable()
+{
+	delete [] m_entries;
+}
+
+void PawnTable::clear()
+{
+	// An all zero entry is right for the key of a board without pawns
+	memset(m_entries, 0, (m_mask + 1) * sizeof(Entry));
+}
+
+// End of file pawntable.cpp
@@ -0,0 +1,69 @@
+/***************************************************************************
+ * Brutal Chess
+ * http://brutalchess.sf.net
+ *
+ * File : pawntable.h
+ * Authors : Mike Cook, Joe Flint, Neil Pankey
+ **************************************************************************/
+
+#ifndef PAWNTABLE_H
+#define PAWNTABLE_H
+
+/**
+ * A cache of pawn structure evaluations keyed on Board::pawnKey. Pawns
+ * move far less often than pieces during a search, so nearly every
+ * lookup finds the structure already worked out. Each search thread has
+ * a table of its own, so there is no locking.
+ */
+class PawnTable {
+ public:
+	/** What is known about one pawn structure */
+	struct Entry {
+		unsigned long long key;
+
+		/** Score of the structure for white */
+		int score;
+
+		/** Pawns of each color with no enemy pawn able to stop them */
+		unsigned long long passed[2];
+
+		/** Pawns of each color with no friendly pawn on a file next to them */
+		unsigned long long isolated[2];
+
+		/** Pawns of each color sharing their file with a friendly pawn */
+		unsigned long long doubled[2];
+	};
+
+	/**
+	 * Creates a table of about the given size.
+	 * @param kilobytes - Memory to use, rounded down to a power of two entries.
+	 */
+	PawnTable(int kilobytes = DEFAULT_SIZE);
+
+	~PawnTable();
+
+	/**
+	 * Returns the entry key would be kept in. It only describes key's
+	 * structure if its key matches, otherwise the caller fills it in.
+	 */
+	Entry & lookup(unsigned long long key)
+		{ return m_entries[key & m_mask]; }
+
+	/** Empties the table. */
+	void clear();
+
+	/** Default table size in kilobytes */
+	static const int DEFAULT_SIZE = 256;
+
+ private:
+	// Not copyable, each thread owns its own
+	PawnTable(const PawnTable &);
+	PawnTable & operator=(const PawnTable &);
+
+	Entry * m_entries;
+	unsigned long long m_mask;
+};
+
+#endif // PAWNTABLE_H
+
+// End of file pawntable.h
@@ -0,0 +1,162 @@
+/***************************************************************************
+ * Brutal Chess
+ * http://brutalchess.sf.net
+ *
+ * File : searchstats.h
+ * Authors : Mike Cook, Joe Flint, Neil Pankey
+ **************************************************************************/
+
+#ifndef SEARCHSTATS_H
+#define SEARCHSTATS_H
+
+#include <cmath>
+#include <ostream>
+
+/**
+ * Counters filled in by a search. They are reset at the start of every
+ * think so they always describe the most recent search. Players that
+ * don't search leave them all at zero.
+ */
+struct SearchStats {
+	SearchStats()
+		{ reset(); }
+
+	/** Zero all of the counters */
+	void reset()
+	{
+		nodes = 0;
+		qnodes = 0;
+		tt_probes = 0;
+		tt_hits = 0;
+		beta_cutoffs = 0;
+		first_move_cutoffs = 0;
+		seldepth = 0;
+		depth = 0;
+		time = 0;
+		null_cutoffs = 0;
+		lmr_reductions = 0;
+		lmr_researches = 0;
+		futility_pruned = 0;
+		razor_cutoffs = 0;
+		tb_hits = 0;
+		repetitions = 0;
+		pawn_probes = 0;
+		pawn_hits = 0;
+	}
+
+	/**
+	 * Adds in the counters of another search, e.g. a helper thread. The
+	 * depths and time are maximums rather than sums.
+	 */
+	SearchStats & operator+=(const SearchStats & other)
+	{
+		nodes += other.nodes;
+		qnodes += other.qnodes;
+		tt_probes += other.tt_probes;
+		tt_hits += other.tt_hits;
+		beta_cutoffs += other.beta_cutoffs;
+		first_move_cutoffs += other.first_move_cutoffs;
+		if(other.seldepth > seldepth)
+			seldepth = other.seldepth;
+		if(other.depth > depth)
+			depth = other.depth;
+		if(other.time > time)
+			time = other.time;
+		null_cutoffs += other.null_cutoffs;
+		lmr_reductions += other.lmr_reductions;
+		lmr_researches += other.lmr_researches;
+		futility_pruned += other.futility_pruned;
+		razor_cutoffs += other.razor_cutoffs;
+		tb_hits += other.tb_hits;
+		repetitions += other.repetitions;
+		pawn_probes += other.pawn_probes;
+		pawn_hits += other.pawn_hits;
+		return *this;
+	}
+
+	/** Main search plus quiescence nodes */
+	unsigned long totalNodes() const
+		{ return nodes + qnodes; }
+
+	/** Nodes per second over the whole search */
+	unsigned long nps() const
+		{ return time ? (unsigned long)(totalNodes() * 1000.0 / time) : 0; }
+
+	/**
+	 * Fraction of beta cutoffs produced by the first move searched, a
+	 * measure of how good the move ordering is.
+	 */
+	double firstMoveCutoffRate() const
+		{ return beta_cutoffs ? (double)first_move_cutoffs / beta_cutoffs : 0.0; }
+
+	/** Fraction of transposition table probes that found the position */
+	double ttHitRate() const
+		{ return tt_probes ? (double)tt_hits / tt_probes : 0.0; }
+
+	/** Fraction of pawn structures found in the pawn table */
+	double pawnHitRate() const
+		{ return pawn_probes ? (double)pawn_hits / pawn_probes : 0.0; }
+
+	/** Effective branching factor, the depth'th root of the node count */
+	double branchingFactor() const
+		{ return (depth > 0 && nodes > 0) ? pow((double)nodes, 1.0 / depth) : 0.0; }
+
+	/** Nodes visited by the main search */
+	unsigned long nodes;
+	/** Nodes visited by the quiescence search */
+	unsigned long qnodes;
+	/** Transposition table lookups, and how many of them found an entry */
+	unsigned long tt_probes;
+	unsigned long tt_hits;
+	/** Nodes that failed high, and how many did so on the first move */
+	unsigned long beta_cutoffs;
+	unsigned long first_move_cutoffs;
+	/** Deepest ply reached including the quiescence search */
+	int seldepth;
+	/** Last iteration the search completed */
+	int depth;
+	/** Wall clock time of the search in milliseconds */
+	unsigned long time;
+
+	/** Null move searches that failed high */
+	unsigned long null_cutoffs;
+	/** Quiet moves searched at reduced depth */
+	unsigned long lmr_reductions;
+	/** Reduced searches that had to be repeated at full depth */
+	unsigned long lmr_researches;
+	/** Quiet moves skipped at frontier nodes */
+	unsigned long futility_pruned;
+	/** Nodes resolved by a quiescence search after razoring */
+	unsigned long razor_cutoffs;
+	/** Nodes answered by the endgame tables */
+	unsigned long tb_hits;
+	/** Nodes drawn by a repetition or the fifty move rule */
+	unsigned long repetitions;
+	/** Pawn table lookups, and how many of them found the structure */
+	unsigned long pawn_probes;
+	unsigned long pawn_hits;
+};
+
+/** Writes a one line summary of the search, suitable for logs. */
+inline std::ostream & operator<<(std::ostream & out, const SearchStats & stats)
+{
+	out << "depth " << stats.depth << "/" << stats.seldepth
+	    << " nodes " << stats.totalNodes() << " (" << stats.qnodes << " q)"
+	    << " time " << stats.time << "ms"
+	    << " nps " << stats.nps()
+	    << " ebf " << stats.branchingFactor()
+	    << " tt " << (int)(100 * stats.ttHitRate()) << "%"
+	    << " first " << (int)(100 * stats.firstMoveCutoffRate()) << "%"
+	    << " pawns " << (int)(100 * stats.pawnHitRate()) << "%";
+	if(stats.tb_hits) {
+		out << " tbhits " << stats.tb_hits;
+	}
+	if(stats.repetitions) {
+		out << " reps " << stats.repetitions;
+	}
+	return out;
+}
+
+#endif
+
+// End of file searchstats.h
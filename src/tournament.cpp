@@ -0,0 +1,930 @@
+/***************************************************************************
+ * Brutal Chess
+ * http://brutalchess.sf.net
+ *
+ * File : tournament.cpp
+ * Authors : Mike Cook, Joe Flint, Neil Pankey
+ **************************************************************************/
+
+#include "board.h"
+#include "chessgamestate.h"
+#include "chessplayer.h"
+#include "egtb.h"
+#include "network.h"
+#include "openingbook.h"
+#include "options.h"
+#include "SDL.h"
+#include "SDL_thread.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef WIN32
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// Longest line of moves in the PGN file
+static const int PGN_WIDTH = 79;
+
+/**
+ * A player as given on the command line, a PlayerFactory name followed
+ * for Brutal by its settings, e.g. Brutal:ply=6,hash=32.
+ */
+struct PlayerSpec {
+	string name;
+	string type;
+	vector<pair<string, string> > settings;
+};
+
+/** One finished game, as it goes into the PGN file. */
+struct GameRecord {
+	bool player1white;
+
+	/** Starting position, empty for the usual one */
+	string fen;
+
+	vector<string> moves;
+	string result;
+	string reason;
+
+	// Time in ms each player took over each of its moves, player 1 first
+	vector<Uint32> times[2];
+};
+
+/**
+ * Everything the game threads share. The counters and the PGN file are
+ * only touched with lock held, the rest is fixed before the games start.
+ */
+struct Tournament {
+	PlayerSpec players[2];
+	vector<string> openings;
+	int games;
+
+	// Time control in ms, no clock if base is 0
+	unsigned int base, increment;
+
+	// Moves each before a game is called a draw, 0 for no limit
+	int maxmoves;
+
+	// Sequential probability ratio test of elo0 against elo1, if sprt
+	bool sprt;
+	double elo0, elo1, alpha, beta;
+
+	ofstream pgn;
+	ostream * report;
+
+	SDL_mutex * lock;
+	int next;
+	bool stopped;
+
+	// Results so far, for player 1
+	int wins, losses, draws;
+
+	// Think times of every move of each player so far
+	vector<Uint32> times[2];
+};
+
+void printTournamentUsage()
+{
+	cerr << "Usage: brutaltournament [--games=N] [--concurrency=N] [--openings=FILE] [--tc=SECONDS[+INC]]" << endl;
+	cerr << "                        [--maxmoves=N] [--pgn=FILE] [--sprt=ELO0,ELO1] [--alpha=A] [--beta=B]" << endl;
+	cerr << "                        [--net=FILE] [--egtb=DIR] PLAYER1 PLAYER2 | --calibrate" << endl;
+	cerr << endl;
+	cerr << " PLAYER\t\t\t Brutal, GnuChess, Faile or Random. Brutal takes settings" << endl;
+	cerr << "\t\t\t after a colon, e.g. Brutal:ply=6,hash=32,book=off:" << endl;
+	cerr << "\t\t\t   level=easy|medium|hard, first as it sets the others" << endl;
+	cerr << "\t\t\t   ply=N threads=N hash=MB movetime=MS nodes=N mate=N noise=CP" << endl;
+	cerr << "\t\t\t   book, tb, net, nullmove, lmr, futility, razoring, ponder=on|off" << endl;
+	cerr << "\t\t\t The book and pondering are off unless turned on." << endl;
+	cerr << " --calibrate\t\t Play each difficulty level against the one below it, and" << endl;
+	cerr << "\t\t\t easy against Random, to measure their strength and move times." << endl;
+	cerr << " --games=N\t\t Games to play, 100 by default. Each opening is played" << endl;
+	cerr << "\t\t\t twice with the colors swapped." << endl;
+	cerr << " --concurrency=N\t Games played at once, enough to keep every core busy" << endl;
+	cerr << "\t\t\t by default." << endl;
+	cerr << " --openings=FILE\t FEN or EPD positions to start the games from, in turn." << endl;
+	cerr << " --tc=SECONDS[+INC]\t Clock of each player, e.g. 10+0.1, none by default." << endl;
+	cerr << " --maxmoves=N\t\t Call a game a draw after N moves each, no limit by default." << endl;
+	cerr << " --pgn=FILE\t\t Write the games to FILE." << endl;
+	cerr << " --sprt=ELO0,ELO1\t Stop once a sequential probability ratio test has decided" << endl;
+	cerr << "\t\t\t whether PLAYER1 is ELO0 or ELO1 stronger." << endl;
+	cerr << " --alpha=A --beta=B\t False positive and negative rates of the test, 0.05 by default." << endl;
+	cerr << " --net=FILE\t\t Neural network weights for Brutal players with net=on." << endl;
+	cerr << " --egtb=DIR\t\t Directory of endgame tables for Brutal players." << endl;
+	exit(1);
+}
+
+// Splits a player's command line text into its type and settings
+static bool parsePlayer(const string & text, PlayerSpec & spec)
+{
+	spec.name = text;
+	spec.settings.clear();
+
+	string::size_type colon = text.find(':');
+	spec.type = text.substr(0, colon);
+	if(colon == string::npos) {
+		return true;
+	}
+
+	string list = text.substr(colon + 1);
+	string::size_type start = 0, comma;
+	do {
+		comma = list.find(',', start);
+		string setting = list.substr(start, comma - start);
+		string::size_type equals = setting.find('=');
+		if(equals == string::npos) {
+			return false;
+		}
+		spec.settings.push_back(make_pair(setting.substr(0, equals), setting.substr(equals + 1)));
+		start = comma + 1;
+	} while(comma != string::npos);
+	return true;
+}
+
+// Reads a difficulty level setting
+static bool parseLevel(const string & value, Difficulty & level)
+{
+	if(value == "easy") {
+		level = EASY;
+	} else if(value == "medium") {
+		level = MEDIUM;
+	} else if(value == "hard") {
+		level = HARD;
+	} else {
+		return false;
+	}
+	return true;
+}
+
+// Reads an on|off setting
+static bool parseSwitch(const string & value, bool & on)
+{
+	if(value == "on") {
+		on = true;
+	} else if(value == "off") {
+		on = false;
+	} else {
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Makes a player from spec, or returns 0 with the reason in error. Brutal
+ * players search with the whole clock rather than to a fixed depth when
+ * there is a time control, unless they are given a ply.
+ */
+static ChessPlayer * createPlayer(const PlayerSpec & spec, bool clock, string & error)
+{
+	ChessPlayer * player = PlayerFactory(spec.type);
+	if(!player || player->isHuman()) {
+		error = "Unknown player " + spec.type;
+		delete player;
+		return 0;
+	}
+
+	BrutalPlayer * brutal = dynamic_cast<BrutalPlayer*>(player);
+	if(!brutal) {
+		if(!spec.settings.empty()) {
+			error = "Only Brutal players take settings";
+			delete player;
+			return 0;
+		}
+		return player;
+	}
+
+	brutal->setThreads(1);
+	brutal->setUseBook(false);
+	brutal->setPondering(false);
+	if(clock) {
+		brutal->setPly(BrutalPlayer::MAX_DEPTH - 1);
+	}
+
+	for(size_t i = 0; i < spec.settings.size(); i++) {
+		const string & name = spec.settings[i].first;
+		const string & value = spec.settings[i].second;
+		int number = atoi(value.c_str());
+		bool on = false;
+		Difficulty level;
+
+		if(name == "level" && parseLevel(value, level)) {
+			brutal->setDifficulty(level);
+		} else if(name == "ply" && number > 0 && number < BrutalPlayer::MAX_DEPTH) {
+			brutal->setPly(number);
+		} else if(name == "threads" && number > 0) {
+			brutal->setThreads(number);
+		} else if(name == "hash" && number > 0) {
+			brutal->setHashSize(number);
+		} else if(name == "movetime" && number > 0) {
+			brutal->setMoveTime(number);
+		} else if(name == "nodes" && number >= 0) {
+			brutal->setMaxNodes(number);
+		} else if(name == "noise" && number >= 0) {
+			brutal->setEvalNoise(number);
+		} else if(name == "mate" && number >= 0) {
+			brutal->setMateSearch(number);
+		} else if(name == "book" && parseSwitch(value, on)) {
+			brutal->setUseBook(on);
+		} else if(name == "tb" && parseSwitch(value, on)) {
+			brutal->setUseTablebases(on);
+		} else if(name == "net" && parseSwitch(value, on)) {
+			brutal->setUseNetwork(on);
+		} else if(name == "nullmove" && parseSwitch(value, on)) {
+			brutal->setNullMovePruning(on);
+		} else if(name == "lmr" && parseSwitch(value, on)) {
+			brutal->setLateMoveReductions(on);
+		} else if(name == "futility" && parseSwitch(value, on)) {
+			brutal->setFutilityPruning(on);
+		} else if(name == "razoring" && parseSwitch(value, on)) {
+			brutal->setRazoring(on);
+		} else if(name == "ponder" && parseSwitch(value, on)) {
+			brutal->setPondering(on);
+		} else {
+			error = "Bad setting " + name + "=" + value + " for " + spec.name;
+			delete player;
+			return 0;
+		}
+	}
+	return player;
+}
+
+// Cores the threads of one game keep busy, only one side thinks at a time
+static int threadsPerGame(const Tournament & t)
+{
+	int most = 1;
+	for(int i = 0; i < 2; i++) {
+		for(size_t j = 0; j < t.players[i].settings.size(); j++) {
+			if(t.players[i].settings[j].first == "threads") {
+				most = max(most, atoi(t.players[i].settings[j].second.c_str()));
+			}
+		}
+	}
+	return most;
+}
+
+/**
+ * Finds move among the legal moves of color on board, returning false if
+ * it isn't one. Promotions that don't say what to are to a queen. The
+ * board's own copy of the move replaces it.
+ */
+static bool findLegalMove(const Board & board, Piece::Color color, BoardMove & move)
+{
+	if(!move.isValid()) {
+		return false;
+	}
+	Piece::Type promote = move.getPromotion();
+	vector<BoardMove> moves = board.possibleMoves(color);
+	for(size_t i = 0; i < moves.size(); i++) {
+		const BoardMove & legal = moves[i];
+		if(legal.origin() == move.origin() && legal.dest() == move.dest() &&
+		   (legal.getPromotion() == promote ||
+		    (promote == Piece::NOTYPE && legal.getPromotion() == Piece::QUEEN))) {
+			move = legal;
+			return true;
+		}
+	}
+	return false;
+}
+
+// Writes move, which must be legal on board, in standard algebraic notation
+static string toSAN(const Board & board, const BoardMove & move)
+{
+	static const char LETTERS[] = "PRNBQK";
+	Piece * piece = board.getPiece(move.origin());
+	Piece::Type type = piece->type();
+	Piece::Color color = piece->color();
+	bool capture = board.isOccupied(move.dest()) ||
+	               (type == Piece::PAWN && move.fileDiff() != 0);
+
+	ostringstream san;
+	if(type == Piece::KING && move.fileDiff() == 2) {
+		san << (move.signedFileDiff() > 0 ? "O-O" : "O-O-O");
+	} else if(type == Piece::PAWN) {
+		if(capture) {
+			san << move.origin().filec() << 'x';
+		}
+		san << move.dest();
+		if(move.getPromotion() != Piece::NOTYPE) {
+			san << '=' << LETTERS[move.getPromotion()];
+		}
+	} else {
+		// Another piece of the same kind that can get there is told apart by
+		// file if it can be, then by rank, then by both
+		bool ambiguous = false, samefile = false, samerank = false;
+		vector<BoardMove> moves = board.possibleMoves(color);
+		for(size_t i = 0; i < moves.size(); i++) {
+			const BoardMove & other = moves[i];
+			if(other.dest() == move.dest() && other.origin() != move.origin() &&
+			   board.getPiece(other.origin())->type() == type) {
+				ambiguous = true;
+				samefile = samefile || other.origin().file() == move.origin().file();
+				samerank = samerank || other.origin().rank() == move.origin().rank();
+			}
+		}
+
+		san << LETTERS[type];
+		if(ambiguous && !samefile) {
+			san << move.origin().filec();
+		} else if(ambiguous && !samerank) {
+			san << move.origin().rank();
+		} else if(ambiguous) {
+			san << move.origin();
+		}
+		if(capture) {
+			san << 'x';
+		}
+		san << move.dest();
+	}
+
+	Board after = board;
+	after.update(move);
+	Piece::Color opponent = Piece::opposite(color);
+	if(after.isCheckMate(opponent)) {
+		san << '#';
+	} else if(after.isCheck(opponent)) {
+		san << '+';
+	}
+	return san.str();
+}
+
+// Fills in the result and returns true if the game is over
+static bool isGameOver(const ChessGameState & cgs, GameRecord & record)
+{
+	record.result = "1/2-1/2";
+	switch(cgs.getStatus()) {
+		case ChessGameState::CHECKMATE:
+			record.result = (cgs.getTurn() == Piece::WHITE) ? "0-1" : "1-0";
+			record.reason = (cgs.getTurn() == Piece::WHITE) ? "Black mates" : "White mates";
+			break;
+		case ChessGameState::STALEMATE:
+			record.reason = "Stalemate";
+			break;
+		case ChessGameState::FIFTY_MOVE_DRAW:
+			record.reason = "Draw by the 50 move rule";
+			break;
+		case ChessGameState::THREEFOLD_DRAW:
+			record.reason = "Draw by repetition";
+			break;
+		case ChessGameState::MATERIAL_DRAW:
+			record.reason = "Insufficient material";
+			break;
+		default:
+			return false;
+	}
+	return true;
+}
+
+// Ends the game with color losing
+static void forfeit(GameRecord & record, Piece::Color color, const string & reason)
+{
+	record.result = (color == Piece::WHITE) ? "0-1" : "1-0";
+	record.reason = string(color == Piece::WHITE ? "White" : "Black") + " " + reason;
+}
+
+/**
+ * Plays game number game of the tournament into record. Games go in pairs
+ * from the same opening, player 1 taking white in the first of each pair.
+ */
+static void playGame(const Tournament & t, int game, GameRecord & record)
+{
+	record.player1white = (game % 2 == 0);
+	record.moves.clear();
+	record.times[0].clear();
+	record.times[1].clear();
+
+	ChessGameState cgs;
+	if(!t.openings.empty()) {
+		cgs.loadFEN(t.openings[(game / 2) % t.openings.size()]);
+		record.fen = cgs.toFEN();
+	}
+
+	// Indexed by color, the specs were checked before any game started
+	string error;
+	ChessPlayer * players[Piece::LAST_COLOR + 1];
+	players[Piece::WHITE] = createPlayer(t.players[record.player1white ? 0 : 1], t.base > 0, error);
+	players[Piece::BLACK] = createPlayer(t.players[record.player1white ? 1 : 0], t.base > 0, error);
+	players[Piece::WHITE]->setIsWhite(true);
+	players[Piece::BLACK]->setIsWhite(false);
+
+	unsigned int clock[Piece::LAST_COLOR + 1] = { t.base, t.base };
+	for(int c = 0; c <= Piece::LAST_COLOR; c++) {
+		players[c]->newGame();
+		if(!record.fen.empty()) {
+			players[c]->loadGame(cgs);
+		}
+	}
+	if(t.base) {
+		players[cgs.getTurn()]->setClock(clock[cgs.getTurn()], t.increment);
+	}
+	players[Piece::WHITE]->startGame();
+	players[Piece::BLACK]->startGame();
+
+	int plies = 0;
+	while(!isGameOver(cgs, record)) {
+		if(t.maxmoves && plies >= 2 * t.maxmoves) {
+			record.result = "1/2-1/2";
+			record.reason = "Move limit reached";
+			break;
+		}
+
+		Piece::Color turn = cgs.getTurn();
+		ChessPlayer * player = players[turn];
+		player->resetInterrupt();
+		Uint32 start = SDL_GetTicks();
+		player->think(cgs);
+		Uint32 elapsed = SDL_GetTicks() - start;
+		record.times[(turn == Piece::WHITE) == record.player1white ? 0 : 1].push_back(elapsed);
+
+		if(t.base) {
+			if(elapsed >= clock[turn]) {
+				forfeit(record, turn, "loses on time");
+				break;
+			}
+			clock[turn] += t.increment - elapsed;
+		}
+
+		Board board = cgs.getBoard();
+		BoardMove move = player->getMove();
+		if(!findLegalMove(board, turn, move)) {
+			forfeit(record, turn, "makes an illegal move");
+			break;
+		}
+		record.moves.push_back(toSAN(board, move));
+		cgs.update(move);
+		plies++;
+
+		Piece::Color opponent = Piece::opposite(turn);
+		if(t.base) {
+			players[opponent]->setClock(clock[opponent], t.increment);
+		}
+		players[opponent]->opponentMove(move, cgs);
+	}
+
+	delete players[Piece::WHITE];
+	delete players[Piece::BLACK];
+}
+
+// Writes a game in PGN, its moves wrapped to PGN_WIDTH
+static void writePGN(ostream & out, const Tournament & t, int game, const GameRecord & record)
+{
+	time_t now = time(NULL);
+	char date[16];
+	strftime(date, sizeof(date), "%Y.%m.%d", localtime(&now));
+
+	const PlayerSpec & white = t.players[record.player1white ? 0 : 1];
+	const PlayerSpec & black = t.players[record.player1white ? 1 : 0];
+	out << "[Event \"Brutal Chess tournament\"]" << endl;
+	out << "[Site \"?\"]" << endl;
+	out << "[Date \"" << date << "\"]" << endl;
+	out << "[Round \"" << game + 1 << "\"]" << endl;
+	out << "[White \"" << white.name << "\"]" << endl;
+	out << "[Black \"" << black.name << "\"]" << endl;
+	out << "[Result \"" << record.result << "\"]" << endl;
+	if(!record.fen.empty()) {
+		out << "[SetUp \"1\"]" << endl;
+		out << "[FEN \"" << record.fen << "\"]" << endl;
+	}
+	if(t.base) {
+		out << "[TimeControl \"" << t.base / 1000.0 << "+" << t.increment / 1000.0 << "\"]" << endl;
+	}
+	out << endl;
+
+	// The move number and side to move come from the FEN's last fields
+	int number = 1;
+	bool whiteturn = true;
+	if(!record.fen.empty()) {
+		istringstream fields(record.fen);
+		string placement, turn, castling, enpassant;
+		int halfmoves;
+		fields >> placement >> turn >> castling >> enpassant >> halfmoves >> number;
+		whiteturn = (turn == "w");
+	}
+
+	vector<string> words;
+	for(size_t i = 0; i < record.moves.size(); i++) {
+		ostringstream word;
+		if(whiteturn) {
+			word << number << ". ";
+		} else if(i == 0) {
+			word << number << "... ";
+		}
+		word << record.moves[i];
+		words.push_back(word.str());
+		if(!whiteturn) {
+			number++;
+		}
+		whiteturn = !whiteturn;
+	}
+	words.push_back("{" + record.reason + "}");
+	words.push_back(record.result);
+
+	int column = 0;
+	for(size_t i = 0; i < words.size(); i++) {
+		if(column > 0 && column + 1 + (int)words[i].size() > PGN_WIDTH) {
+			out << endl;
+			column = 0;
+		} else if(column > 0) {
+			out << ' ';
+			column++;
+		}
+		out << words[i];
+		column += (int)words[i].size();
+	}
+	out << endl << endl;
+}
+
+// Elo difference that gives an expected score of score
+static double eloFromScore(double score)
+{
+	return -400.0 * log10(1.0 / score - 1.0);
+}
+
+static double scoreFromElo(double elo)
+{
+	return 1.0 / (1.0 + pow(10.0, -elo / 400.0));
+}
+
+// Works out the mean score of a game from its wins, draws and losses, and
+// the variance of one game's score
+static void scoreStatistics(double wins, double draws, double losses, double & score,
+                            double & variance)
+{
+	double n = wins + draws + losses;
+	score = (wins + 0.5 * draws) / n;
+	variance = (wins * (1.0 - score) * (1.0 - score) + draws * (0.5 - score) * (0.5 - score) +
+	            losses * score * score) / n;
+}
+
+/**
+ * Returns the log likelihood ratio of player 1 being elo1 rather than
+ * elo0 stronger, treating the mean score as normally distributed.
+ */
+static double likelihoodRatio(const Tournament & t)
+{
+	// A result that hasn't come up yet counts as half a game, or a clean
+	// sweep would have no variance and prove nothing
+	double wins = t.wins ? t.wins : 0.5;
+	double draws = t.draws ? t.draws : 0.5;
+	double losses = t.losses ? t.losses : 0.5;
+	double n = wins + draws + losses;
+	double score, variance;
+	scoreStatistics(wins, draws, losses, score, variance);
+
+	double s0 = scoreFromElo(t.elo0), s1 = scoreFromElo(t.elo1);
+	return (s1 - s0) * (2.0 * score - s0 - s1) * n / (2.0 * variance);
+}
+
+// Prints the score so far, and the test's verdict once it has one
+static void printScore(const Tournament & t)
+{
+	ostream & out = *t.report;
+	int n = t.wins + t.losses + t.draws;
+	double score, variance;
+	scoreStatistics(t.wins, t.draws, t.losses, score, variance);
+	out << "Score of " << t.players[0].name << " vs " << t.players[1].name << ": ";
+	out << t.wins << " - " << t.losses << " - " << t.draws;
+	out << "  [" << fixed << setprecision(3) << score << "] " << n << endl;
+
+	if(t.wins > 0 && t.losses > 0) {
+		double margin = 1.96 * sqrt(variance / n);
+		double low = max(score - margin, 1e-6), high = min(score + margin, 1.0 - 1e-6);
+		// Rounded so an even score doesn't print as -0.0
+		double elo = floor(eloFromScore(score) * 10.0 + 0.5) / 10.0;
+		out << "Elo difference: " << setprecision(1) << elo + 0.0;
+		out << " +/- " << (eloFromScore(high) - eloFromScore(low)) / 2.0 << endl;
+	}
+
+	if(t.sprt) {
+		double lower = log(t.beta / (1.0 - t.alpha)), upper = log((1.0 - t.beta) / t.alpha);
+		double llr = likelihoodRatio(t);
+		out << "SPRT: llr " << setprecision(2) << llr << " (" << lower << ", " << upper << "), ";
+		out << "elo0 " << t.elo0 << ", elo1 " << t.elo1;
+		if(llr >= upper) {
+			out << ", H1 accepted";
+		} else if(llr <= lower) {
+			out << ", H0 accepted";
+		}
+		out << endl;
+	}
+	out.unsetf(ios::floatfield);
+	out << setprecision(6);
+}
+
+// Counts a finished game, writes it out and runs the test. Called with the
+// lock held.
+static void finishGame(Tournament & t, int game, const GameRecord & record)
+{
+	if(record.result == "1/2-1/2") {
+		t.draws++;
+	} else if((record.result == "1-0") == record.player1white) {
+		t.wins++;
+	} else {
+		t.losses++;
+	}
+
+	for(int i = 0; i < 2; i++) {
+		t.times[i].insert(t.times[i].end(), record.times[i].begin(), record.times[i].end());
+	}
+
+	if(t.pgn.is_open()) {
+		writePGN(t.pgn, t, game, record);
+		t.pgn.flush();
+	}
+
+	ostream & out = *t.report;
+	const PlayerSpec & white = t.players[record.player1white ? 0 : 1];
+	const PlayerSpec & black = t.players[record.player1white ? 1 : 0];
+	out << "Game " << game + 1 << " (" << white.name << " vs " << black.name << "): ";
+	out << record.result << " {" << record.reason << "}" << endl;
+	printScore(t);
+
+	if(t.sprt) {
+		double llr = likelihoodRatio(t);
+		if(llr >= log((1.0 - t.beta) / t.alpha) || llr <= log(t.beta / (1.0 - t.alpha))) {
+			t.stopped = true;
+		}
+	}
+}
+
+/**
+ * Prints the spread of a player's think times, with the time limit of
+ * its difficulty level if it has one. Every move should come in under it.
+ */
+static void printLatency(const Tournament & t, int player)
+{
+	vector<Uint32> times = t.times[player];
+	if(times.empty()) {
+		return;
+	}
+	sort(times.begin(), times.end());
+	size_t n = times.size();
+
+	ostream & out = *t.report;
+	out << "Move times of " << t.players[player].name << ": median " << times[n / 2];
+	out << " ms, 90% " << times[n * 90 / 100] << ", 99% " << times[n * 99 / 100];
+	out << ", max " << times[n - 1] << " over " << n << " moves";
+
+	// Other settings or a clock could change the limit, so only a lone
+	// level counts
+	const vector<pair<string, string> > & settings = t.players[player].settings;
+	Difficulty level;
+	if(t.base == 0 && settings.size() == 1 && settings[0].first == "level" &&
+	   parseLevel(settings[0].second, level)) {
+		out << ", limit " << Options::getInstance()->profiles[level].movetime;
+	}
+	out << endl;
+}
+
+// Plays games until there are none left to start
+static int gameThread(void * data)
+{
+	Tournament * t = (Tournament*)data;
+	GameRecord record;
+
+	for(;;) {
+		SDL_LockMutex(t->lock);
+		int game = t->next++;
+		bool done = t->stopped || game >= t->games;
+		SDL_UnlockMutex(t->lock);
+		if(done) {
+			return 0;
+		}
+
+		playGame(*t, game, record);
+
+		SDL_LockMutex(t->lock);
+		finishGame(*t, game, record);
+		SDL_UnlockMutex(t->lock);
+	}
+}
+
+// Reads the FEN or EPD positions in filename, one to a line
+static bool readOpenings(const string & filename, vector<string> & openings)
+{
+	ifstream in(filename.c_str());
+	if(!in) {
+		cerr << "Unable to read " << filename << endl;
+		return false;
+	}
+
+	string line;
+	int number = 0;
+	while(getline(in, line)) {
+		number++;
+		if(!line.empty() && line[line.size() - 1] == '\r') {
+			line.erase(line.size() - 1);
+		}
+		if(line.empty() || line[0] == '#') {
+			continue;
+		}
+		ChessGameState cgs;
+		if(!cgs.loadFEN(line)) {
+			cerr << filename << ":" << number << ": not a position" << endl;
+			return false;
+		}
+		openings.push_back(line);
+	}
+	return !openings.empty();
+}
+
+/**
+ * Plays the games of player1 against player2, concurrency at a time, and
+ * reports the result. Returns false if either player can't be made.
+ */
+static bool playMatch(Tournament & t, const string & player1, const string & player2, int concurrency)
+{
+	const string names[2] = { player1, player2 };
+	for(int i = 0; i < 2; i++) {
+		if(!parsePlayer(names[i], t.players[i])) {
+			cerr << "Bad settings in " << names[i] << endl;
+			printTournamentUsage();
+		}
+	}
+
+	// Making each player once checks its settings, and sets up everything
+	// the players share before the game threads could race to
+	for(int i = 0; i < 2; i++) {
+		string error;
+		ChessPlayer * player = createPlayer(t.players[i], t.base > 0, error);
+		if(!player) {
+			cerr << error << endl;
+			return false;
+		}
+		delete player;
+	}
+
+	if(concurrency == 0) {
+		int cores = 1;
+#ifndef WIN32
+		cores = max(1, (int)sysconf(_SC_NPROCESSORS_ONLN));
+#endif
+		concurrency = max(1, cores / threadsPerGame(t));
+	}
+	concurrency = min(concurrency, t.games);
+
+	t.next = 0;
+	t.stopped = false;
+	t.wins = t.losses = t.draws = 0;
+	t.times[0].clear();
+	t.times[1].clear();
+
+	ostream & report = *t.report;
+	report << "Playing " << t.games << " games of " << t.players[0].name << " vs ";
+	report << t.players[1].name << ", " << concurrency << " at a time" << endl;
+
+	vector<SDL_Thread*> handles;
+	for(int i = 1; i < concurrency; i++) {
+		SDL_Thread * thread = SDL_CreateThread(gameThread, &t);
+		if(thread == NULL) {
+			cerr << "Unable to create game thread: " << SDL_GetError() << endl;
+			break;
+		}
+		handles.push_back(thread);
+	}
+	gameThread(&t);
+	for(size_t i = 0; i < handles.size(); i++) {
+		SDL_WaitThread(handles[i], NULL);
+	}
+
+	printLatency(t, 0);
+	printLatency(t, 1);
+	return true;
+}
+
+int main(int argc, char * argv[])
+{
+	Tournament t;
+	t.games = 100;
+	t.base = 0;
+	t.increment = 0;
+	t.maxmoves = 0;
+	t.sprt = false;
+	t.elo0 = 0.0;
+	t.elo1 = 5.0;
+	t.alpha = 0.05;
+	t.beta = 0.05;
+
+	int concurrency = 0;
+	bool calibrate = false;
+	string openings, pgn;
+	vector<string> players;
+
+	for(int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		if(arg.substr(0, 8) == "--games=") {
+			t.games = atoi(arg.substr(8).c_str());
+		} else if(arg.substr(0, 14) == "--concurrency=") {
+			concurrency = atoi(arg.substr(14).c_str());
+			if(concurrency < 1) {
+				printTournamentUsage();
+			}
+		} else if(arg.substr(0, 11) == "--openings=") {
+			openings = arg.substr(11);
+		} else if(arg.substr(0, 5) == "--tc=") {
+			string tc = arg.substr(5);
+			string::size_type plus = tc.find('+');
+			t.base = (unsigned int)(atof(tc.substr(0, plus).c_str()) * 1000.0);
+			if(plus != string::npos) {
+				t.increment = (unsigned int)(atof(tc.substr(plus + 1).c_str()) * 1000.0);
+			}
+			if(t.base == 0) {
+				printTournamentUsage();
+			}
+		} else if(arg.substr(0, 11) == "--maxmoves=") {
+			t.maxmoves = atoi(arg.substr(11).c_str());
+		} else if(arg.substr(0, 6) == "--pgn=") {
+			pgn = arg.substr(6);
+		} else if(arg.substr(0, 7) == "--sprt=") {
+			string bounds = arg.substr(7);
+			string::size_type comma = bounds.find(',');
+			if(comma == string::npos) {
+				printTournamentUsage();
+			}
+			t.sprt = true;
+			t.elo0 = atof(bounds.substr(0, comma).c_str());
+			t.elo1 = atof(bounds.substr(comma + 1).c_str());
+		} else if(arg.substr(0, 8) == "--alpha=") {
+			t.alpha = atof(arg.substr(8).c_str());
+		} else if(arg.substr(0, 7) == "--beta=") {
+			t.beta = atof(arg.substr(7).c_str());
+		} else if(arg.substr(0, 6) == "--net=") {
+			Options::getInstance()->netfile = arg.substr(6);
+		} else if(arg.substr(0, 7) == "--egtb=") {
+			Options::getInstance()->egtbpath = arg.substr(7);
+		} else if(arg == "--calibrate") {
+			calibrate = true;
+		} else if(arg.substr(0, 2) != "--") {
+			players.push_back(arg);
+		} else {
+			printTournamentUsage();
+		}
+	}
+
+	if(players.size() != (calibrate ? 0 : 2) || t.games < 1 || t.alpha <= 0.0 || t.alpha >= 1.0 ||
+	   t.beta <= 0.0 || t.beta >= 1.0 || t.elo0 >= t.elo1) {
+		printTournamentUsage();
+	}
+
+	// Each level is measured against the one below, the easiest against
+	// random moves
+	vector<pair<string, string> > matches;
+	if(calibrate) {
+		matches.push_back(make_pair("Brutal:level=easy", "Random"));
+		matches.push_back(make_pair("Brutal:level=medium", "Brutal:level=easy"));
+		matches.push_back(make_pair("Brutal:level=hard", "Brutal:level=medium"));
+	} else {
+		matches.push_back(make_pair(players[0], players[1]));
+	}
+
+	if(!openings.empty() && !readOpenings(openings, t.openings)) {
+		return 1;
+	}
+	if(!pgn.empty()) {
+		t.pgn.open(pgn.c_str());
+		if(!t.pgn) {
+			cerr << "Unable to write " << pgn << endl;
+			return 1;
+		}
+	}
+
+	if(SDL_Init(SDL_INIT_TIMER) < 0) {
+		cerr << "Timer initialization failed: " << SDL_GetError() << endl;
+		return 1;
+	}
+	Board::init();
+	Options::getInstance()->searchthreads = 1;
+	OpeningBook::getInstance();
+
+	// The players and game states chat on cout, the report goes to the
+	// console on its own
+	streambuf * console = cout.rdbuf();
+	ostream report(console);
+	t.report = &report;
+	cout.rdbuf(NULL);
+
+	t.lock = SDL_CreateMutex();
+	bool ok = true;
+	for(size_t i = 0; i < matches.size() && ok; i++) {
+		if(i > 0) {
+			report << endl;
+		}
+		ok = playMatch(t, matches[i].first, matches[i].second, concurrency);
+	}
+	SDL_DestroyMutex(t.lock);
+
+	cout.rdbuf(console);
+	SDL_Quit();
+	return ok ? 0 : 1;
+}
+
+// End of file tournament.cpp
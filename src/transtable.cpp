@@ -0,0 +1,156 @@
+/***************************************************************************
+ * Brutal Chess
+ * http://brutalchess.sf.net
+ *
+ * File : transtable.cpp
+ * Authors : Mike Cook, Joe Flint, Neil Pankey
+ **************************************************************************/
+
+#include "transtable.h"
+
+#include <climits>
+#include <cstring>
+
+// Layout of Entry::data
+//  bits  0-15  packed move
+//  bits 16-23  depth
+//  bits 24-25  bound
+//  bits 26-31  generation
+//  bits 32-63  score
+
+TranspositionTable::TranspositionTable(int megabytes) :
+	m_entries(0),
+	m_mask(0),
+	m_megabytes(0),
+	m_generation(0)
+{
+	resize(megabytes);
+}
+
+TranspositionTable::~TranspositionTable()
+{
+	delete [] m_entries;
+}
+
+void TranspositionTable::resize(int megabytes)
+{
+	if(megabytes < 1) {
+		megabytes = 1;
+	}
+
+	unsigned long long count = BUCKET_SIZE;
+	while(2 * count * sizeof(Entry) <= (unsigned long long)megabytes << 20) {
+		count *= 2;
+	}
+
+	delete [] m_entries;
+	m_entries = new Entry[count];
+	m_mask = count / BUCKET_SIZE - 1;
+	m_megabytes = megabytes;
+	clear();
+}
+
+void TranspositionTable::clear()
+{
+	memset(m_entries, 0, (m_mask + 1) * BUCKET_SIZE * sizeof(Entry));
+}
+
+bool TranspositionTable::probe(unsigned long long key, int & depth, int & score,
+                               Bound & bound, int & move) const
+{
+	const Entry * bucket = m_entries + (key & m_mask) * BUCKET_SIZE;
+
+	for(int i = 0; i < BUCKET_SIZE; i++) {
+		unsigned long long data = bucket[i].data;
+		if((bucket[i].key ^ data) != key || data == 0) {
+			continue;
+		}
+
+		move = data & 0xFFFF;
+		depth = (data >> 16) & 0xFF;
+		bound = Bound((data >> 24) & 0x3);
+		score = (int)(unsigned int)(data >> 32);
+		return true;
+	}
+	return false;
+}
+
+void TranspositionTable::store(unsigned long long key, int depth, int score,
+                               Bound bound, int move)
+{
+	Entry * bucket = m_entries + (key & m_mask) * BUCKET_SIZE;
+
+	// The same position is always overwritten, otherwise the entry worth
+	// least goes: empty, then shallow, then old.
+	Entry * replace = bucket;
+	int worst = INT_MAX;
+	for(int i = 0; i < BUCKET_SIZE; i++) {
+		unsigned long long old = bucket[i].data;
+		if((bucket[i].key ^ old) == key && old != 0) {
+			replace = &bucket[i];
+			if(move == NO_MOVE) {
+				move = old & 0xFFFF;
+			}
+			break;
+		}
+
+		int value = INT_MIN;
+		if(old != 0) {
+			int age = (m_generation - (int)((old >> 26) & GENERATION_MASK)) & GENERATION_MASK;
+			value = (int)((old >> 16) & 0xFF) - AGE_PENALTY * age;
+		}
+		if(value < worst) {
+			worst = value;
+			replace = &bucket[i];
+		}
+	}
+
+	if(depth < 0) {
+		depth = 0;
+	}
+
+	unsigned long long data = (unsigned long long)(move & 0xFFFF) |
+	                          ((unsigned long long)(depth & 0xFF) << 16) |
+	                          ((unsigned long long)bound << 24) |
+	                          ((unsigned long long)m_generation << 26) |
+	                          ((unsigned long long)(unsigned int)score << 32);
+
+	replace->key = key ^ data;
+	replace->data = data;
+}
+
+int TranspositionTable::packMove(const BoardMove & bm)
+{
+	if(!bm.isValid()) {
+		return NO_MOVE;
+	}
+
+	// Origin and destination are never equal, so a valid move never packs
+	// to NO_MOVE.
+	int promote = (bm.getPromotion() == Piece::NOTYPE) ? 0 : bm.getPromotion() + 1;
+	return bm.origin().hash() | (bm.dest().hash() << 6) | (promote << 12);
+}
+
+BoardMove TranspositionTable::unpackMove(int move, const Board & board)
+{
+	BoardMove bm;
+	bm.invalidate();
+
+	if(move == NO_MOVE) {
+		return bm;
+	}
+
+	BoardPosition origin(move & 0x3F);
+	BoardPosition dest((move >> 6) & 0x3F);
+	int promote = (move >> 12) & 0xF;
+
+	Piece * piece = board.getPiece(origin);
+	if(!piece) {
+		return bm;
+	}
+
+	return BoardMove(origin, dest, piece,
+	                 promote ? Piece::Type(promote - 1) : Piece::NOTYPE);
+}
+
+// End of file transtable.cpp
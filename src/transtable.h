@@ -0,0 +1,116 @@
+/***************************************************************************
+ * Brutal Chess
+ * http://brutalchess.sf.net
+ *
+ * File : transtable.h
+ * Authors : Mike Cook, Joe Flint, Neil Pankey
+ **************************************************************************/
+
+#ifndef TRANSTABLE_H
+#define TRANSTABLE_H
+
+#include "board.h"
+#include "boardmove.h"
+
+/**
+ * A hash table of search results keyed on Board::hashKey. Several search
+ * threads may read and write it at once without locking, each entry is
+ * stored with its key xor'ed against its data so a torn write reads back
+ * as a miss instead of as a wrong result.
+ *
+ * The table lives as long as its player, so what one search learns is
+ * there for the next, including after an undo. Entries are kept in small
+ * buckets and tagged with the search that stored them. A new result
+ * replaces the entry in its bucket with the least depth, and entries lose
+ * a little depth for every search since they were stored, so old results
+ * give way to new ones without being thrown out at once.
+ */
+class TranspositionTable {
+ public:
+	/** What the stored score says about the real score of the position. */
+	enum Bound { NONE, UPPER, LOWER, EXACT };
+
+	/**
+	 * Creates a table of about the given size.
+	 * @param megabytes - Memory to use, rounded down to a power of two entries.
+	 */
+	TranspositionTable(int megabytes = DEFAULT_SIZE);
+
+	~TranspositionTable();
+
+	/** Reallocates the table, throwing away everything in it. */
+	void resize(int megabytes);
+
+	/** Empties the table. */
+	void clear();
+
+	/**
+	 * Starts a new generation. Entries stored before are kept, but age and
+	 * become the first to be replaced.
+	 */
+	void newSearch()
+		{ m_generation = (m_generation + 1) & GENERATION_MASK; }
+
+	/**
+	 * Looks up a position. Returns false if it isn't in the table.
+	 * @param key - The hash key of the position.
+	 * @param depth - Set to the depth the stored score was searched to.
+	 * @param score - Set to the stored score.
+	 * @param bound - Set to the kind of score stored.
+	 * @param move - Set to the packed best move, see packMove.
+	 */
+	bool probe(unsigned long long key, int & depth, int & score, Bound & bound, int & move) const;
+
+	/**
+	 * Stores the result of searching a position, over any entry for the
+	 * same position or else the least valuable entry in its bucket. A
+	 * result without a move keeps the move already stored for it.
+	 */
+	void store(unsigned long long key, int depth, int score, Bound bound, int move);
+
+	/** Returns the size of the table in megabytes. */
+	int size() const
+		{ return m_megabytes; }
+
+	/** Packs a move into the few bits an entry keeps. */
+	static int packMove(const BoardMove & bm);
+
+	/**
+	 * Rebuilds a packed move for the given board. Returns an invalid move
+	 * if there is no piece on the origin square.
+	 */
+	static BoardMove unpackMove(int move, const Board & board);
+
+	/** Packed value of "no move" */
+	static const int NO_MOVE = 0;
+
+	static const int DEFAULT_SIZE = 16;
+
+ private:
+	struct Entry {
+		unsigned long long key;
+		unsigned long long data;
+	};
+
+	// Entries in a bucket, a bucket fills a cache line
+	static const int BUCKET_SIZE = 4;
+
+	// Generations wrap around after this, as they only keep 6 bits
+	static const int GENERATION_MASK = 63;
+
+	// Depth an entry loses for each generation it falls behind
+	static const int AGE_PENALTY = 4;
+
+	// Not copyable, the table is shared by pointer
+	TranspositionTable(const TranspositionTable &);
+	TranspositionTable & operator=(const TranspositionTable &);
+
+	Entry * m_entries;
+	unsigned long long m_mask;
+	int m_megabytes;
+	int m_generation;
+};
+
+#endif // TRANSTABLE_H
+
+// End of file transtable.h
@@ -0,0 +1,523 @@
+/***************************************************************************
+ * Brutal Chess
+ * http://brutalchess.sf.net
+ *
+ * File : tuner.cpp
+ * Authors : Mike Cook, Joe Flint, Neil Pankey
+ **************************************************************************/
+
+#include "board.h"
+#include "chessplayer.h"
+#include "SDL.h"
+#include "SDL_thread.h"
+
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Layout of the parameters being tuned: the values of every piece but the
+// king, then the piece-square tables from white's side of the board
+static const int VALUES = 0;
+static const int PAWN_TABLE = VALUES + Piece::QUEEN + 1;
+static const int KNIGHT_TABLE = PAWN_TABLE + 64;
+static const int BISHOP_TABLE = KNIGHT_TABLE + 64;
+static const int KING_TABLE = BISHOP_TABLE + 64;
+static const int END_KING_TABLE = KING_TABLE + 64;
+static const int NUM_PARAMS = END_KING_TABLE + 64;
+
+// Positions evaluated by the engine at a time while loading
+static const int LOAD_BLOCK = 4096;
+
+/**
+ * A labelled position, kept as little as possible. Its pieces are in a
+ * shared list, and the evaluation terms that aren't tuned are summed
+ * into rest once when it is loaded.
+ */
+struct Sample {
+	unsigned int first;
+	unsigned char count;
+	unsigned char phase;
+
+	/** 0 if black won, 1 for a draw, 2 if white won */
+	unsigned char result;
+
+	/** Untuned part of the evaluation, for white */
+	short rest;
+};
+
+/** Every position being tuned on, and the current parameters. */
+struct TrainingSet {
+	vector<Sample> samples;
+
+	// Pieces of every sample, square in the low 6 bits, then 3 of type
+	// and one of color
+	vector<unsigned short> pieces;
+
+	double params[NUM_PARAMS];
+	double scale;
+};
+
+/** A share of the samples, and the loss and gradient over them. */
+struct Job {
+	const TrainingSet * set;
+	size_t begin, end;
+	bool gradient;
+	double loss;
+	double grad[NUM_PARAMS];
+};
+
+/**
+ * Calls f(param, weight) for each parameter the piece adds to the
+ * evaluation, with its weight for white.
+ */
+template <class F>
+static void pieceTerms(unsigned short piece, int phase, F & f)
+{
+	int sq = piece & 63;
+	int type = (piece >> 6) & 7;
+	bool white = (piece >> 9) != 0;
+	double sign = white ? 1.0 : -1.0;
+	if(!white) {
+		sq ^= 56;
+	}
+
+	switch(type) {
+		case Piece::PAWN:
+			f(VALUES + type, sign);
+			f(PAWN_TABLE + sq, sign);
+			break;
+		case Piece::KNIGHT:
+			f(VALUES + type, sign);
+			f(KNIGHT_TABLE + sq, sign);
+			break;
+		case Piece::BISHOP:
+			f(VALUES + type, sign);
+			f(BISHOP_TABLE + sq, sign);
+			break;
+		case Piece::ROOK:
+		case Piece::QUEEN:
+			f(VALUES + type, sign);
+			break;
+		case Piece::KING:
+			f(KING_TABLE + sq, sign * phase / Board::MAX_PHASE);
+			f(END_KING_TABLE + sq, sign * (Board::MAX_PHASE - phase) / Board::MAX_PHASE);
+			break;
+	}
+}
+
+// Sums the tuned terms of a sample
+struct Summer {
+	const double * params;
+	double sum;
+	void operator()(int param, double weight)
+		{ sum += params[param] * weight; }
+};
+
+// Spreads the loss's slope over the parameters of a sample
+struct Spreader {
+	double * grad;
+	double slope;
+	void operator()(int param, double weight)
+		{ grad[param] += slope * weight; }
+};
+
+static double evaluate(const TrainingSet & set, const Sample & s)
+{
+	Summer summer = { set.params, (double)s.rest };
+	for(unsigned int i = s.first; i < s.first + s.count; i++) {
+		pieceTerms(set.pieces[i], s.phase, summer);
+	}
+	return summer.sum;
+}
+
+// Works out a job's share of the loss, and of the gradient if asked to
+static int worker(void * data)
+{
+	Job * job = (Job*)data;
+	const TrainingSet & set = *job->set;
+
+	job->loss = 0.0;
+	for(int i = 0; i < NUM_PARAMS; i++) {
+		job->grad[i] = 0.0;
+	}
+
+	for(size_t n = job->begin; n < job->end; n++) {
+		const Sample & s = set.samples[n];
+		double target = s.result / 2.0;
+		double p = 1.0 / (1.0 + exp(-set.scale * evaluate(set, s)));
+
+		// Logistic loss, clamped away from the log of 0
+		double q = (p < 1e-12) ? 1e-12 : (p > 1.0 - 1e-12) ? 1.0 - 1e-12 : p;
+		job->loss -= target * log(q) + (1.0 - target) * log(1.0 - q);
+
+		if(job->gradient) {
+			Spreader spreader = { job->grad, set.scale * (p - target) };
+			for(unsigned int i = s.first; i < s.first + s.count; i++) {
+				pieceTerms(set.pieces[i], s.phase, spreader);
+			}
+		}
+	}
+	return 0;
+}
+
+/**
+ * Returns the mean loss over the set with its current parameters, and
+ * leaves its gradient in grad if grad isn't 0. Each thread takes an
+ * equal share of the samples.
+ */
+static double loss(const TrainingSet & set, vector<Job> & jobs, double * grad)
+{
+	size_t share = (set.samples.size() + jobs.size() - 1) / jobs.size();
+	for(size_t i = 0; i < jobs.size(); i++) {
+		jobs[i].set = &set;
+		jobs[i].begin = min(set.samples.size(), i * share);
+		jobs[i].end = min(set.samples.size(), (i + 1) * share);
+		jobs[i].gradient = (grad != 0);
+	}
+
+	vector<SDL_Thread*> handles;
+	for(size_t i = 1; i < jobs.size(); i++) {
+		SDL_Thread * thread = SDL_CreateThread(worker, &jobs[i]);
+		if(thread == NULL) {
+			cerr << "Unable to create tuning thread: " << SDL_GetError() << endl;
+			exit(1);
+		}
+		handles.push_back(thread);
+	}
+	worker(&jobs[0]);
+	for(size_t i = 0; i < handles.size(); i++) {
+		SDL_WaitThread(handles[i], NULL);
+	}
+
+	double total = 0.0;
+	if(grad) {
+		for(int p = 0; p < NUM_PARAMS; p++) {
+			grad[p] = 0.0;
+		}
+	}
+	for(size_t i = 0; i < jobs.size(); i++) {
+		total += jobs[i].loss;
+		if(grad) {
+			for(int p = 0; p < NUM_PARAMS; p++) {
+				grad[p] += jobs[i].grad[p] / set.samples.size();
+			}
+		}
+	}
+	return total / set.samples.size();
+}
+
+// Reads a game result out of the text after a position, returning false
+// if there isn't one
+static bool parseResult(const string & text, unsigned char & result)
+{
+	static const char * const WINS[] = { "1-0", "[1.0]", "\"1.0\"", " 1.0" };
+	static const char * const DRAWS[] = { "1/2-1/2", "[0.5]", "\"0.5\"", " 0.5" };
+	static const char * const LOSSES[] = { "0-1", "[0.0]", "\"0.0\"", " 0.0" };
+
+	for(int i = 0; i < 4; i++) {
+		if(text.find(DRAWS[i]) != string::npos) {
+			result = 1;
+			return true;
+		}
+		if(text.find(WINS[i]) != string::npos) {
+			result = 2;
+			return true;
+		}
+		if(text.find(LOSSES[i]) != string::npos) {
+			result = 0;
+			return true;
+		}
+	}
+	return false;
+}
+
+// Works out the untuned part of the engine's evaluation of a block of
+// boards and adds them to the set
+static void addBlock(TrainingSet & set, BrutalPlayer & player, vector<Board> & boards,
+                     vector<unsigned char> & results)
+{
+	vector<int> scores(boards.size());
+	player.evaluateBatch(&boards[0], (int)boards.size(), &scores[0]);
+
+	for(size_t i = 0; i < boards.size(); i++) {
+		const Board & board = boards[i];
+		Sample s;
+		s.first = (unsigned int)set.pieces.size();
+		s.phase = (unsigned char)board.phase();
+		s.result = results[i];
+		s.count = 0;
+
+		for(int sq = 0; sq < 64; sq++) {
+			Piece * p = board.getPiece(BoardPosition(sq));
+			if(p) {
+				set.pieces.push_back((unsigned short)(sq | (p->type() << 6) |
+				                     ((p->color() == Piece::WHITE) << 9)));
+				s.count++;
+			}
+		}
+		s.rest = 0;
+		s.rest = (short)floor(scores[i] - evaluate(set, s) + 0.5);
+		set.samples.push_back(s);
+	}
+	boards.clear();
+	results.clear();
+}
+
+// Sets up board from the piece placement of a FEN, returning false if it
+// isn't one. ChessGameState::loadFEN would do, but it allocates pieces
+// for a game to keep, which adds up over millions of positions.
+static bool parsePlacement(const string & placement, Board & board)
+{
+	static const string TYPES = "prnbqk";
+	board.reset();
+
+	int rank = 7, file = 0, kings = 0;
+	for(size_t i = 0; i < placement.size(); i++) {
+		char c = placement[i];
+		if(c == '/') {
+			rank--;
+			file = 0;
+		} else if(isdigit(c)) {
+			file += c - '0';
+		} else {
+			string::size_type type = TYPES.find((char)tolower(c));
+			if(type == string::npos || rank < 0 || file > 7) {
+				return false;
+			}
+			if(type == Piece::KING) {
+				kings++;
+			}
+			Piece piece(isupper(c) ? Piece::WHITE : Piece::BLACK, Piece::Type(type));
+			board.addPiece(&piece, BoardPosition(rank*8 + file));
+			file++;
+		}
+	}
+	return rank == 0 && kings == 2;
+}
+
+/**
+ * Reads positions with their results, one per line, as a FEN or EPD
+ * followed anywhere on the line by the result: 1-0, 0-1, 1/2-1/2, or
+ * 1.0, 0.0, 0.5 for white, bare or in brackets or quotes.
+ */
+static bool load(TrainingSet & set, const string & filename)
+{
+	ifstream in(filename.c_str());
+	if(!in) {
+		cerr << "Unable to read " << filename << endl;
+		return false;
+	}
+
+	BrutalPlayer player;
+	player.setUseNetwork(false);
+
+	Board board;
+	vector<Board> boards;
+	vector<unsigned char> results;
+	string line;
+	unsigned long skipped = 0;
+	while(getline(in, line)) {
+		// The evaluation is for white, so only the pieces matter
+		istringstream fields(line);
+		string placement, turn, castling, enpassant;
+		fields >> placement >> turn >> castling >> enpassant;
+		string after;
+		getline(fields, after);
+
+		unsigned char result;
+		if(!parseResult(" " + after, result) || !parsePlacement(placement, board)) {
+			skipped++;
+			continue;
+		}
+		boards.push_back(board);
+		results.push_back(result);
+		if((int)boards.size() == LOAD_BLOCK) {
+			addBlock(set, player, boards, results);
+		}
+	}
+	if(!boards.empty()) {
+		addBlock(set, player, boards, results);
+	}
+	if(skipped) {
+		cerr << "Skipped " << skipped << " lines without a position and result" << endl;
+	}
+	return !set.samples.empty();
+}
+
+// Starts from the tables the engine is using now
+static void initParams(TrainingSet & set)
+{
+	for(int t = 0; t <= Piece::QUEEN; t++) {
+		set.params[VALUES + t] = Board::pieceValue[t];
+	}
+	for(int sq = 0; sq < 64; sq++) {
+		const int (*mg)[64] = Board::pieceSquare[Board::MIDDLEGAME][Piece::WHITE];
+		const int (*eg)[64] = Board::pieceSquare[Board::ENDGAME][Piece::WHITE];
+		set.params[PAWN_TABLE + sq] = mg[Piece::PAWN][sq] - Board::pieceValue[Piece::PAWN];
+		set.params[KNIGHT_TABLE + sq] = mg[Piece::KNIGHT][sq] - Board::pieceValue[Piece::KNIGHT];
+		set.params[BISHOP_TABLE + sq] = mg[Piece::BISHOP][sq] - Board::pieceValue[Piece::BISHOP];
+		set.params[KING_TABLE + sq] = mg[Piece::KING][sq];
+		set.params[END_KING_TABLE + sq] = eg[Piece::KING][sq];
+	}
+}
+
+// Finds the scale that turns the current evaluations into the best
+// predictions of the results, by narrowing in on it
+static void fitScale(TrainingSet & set, vector<Job> & jobs)
+{
+	double low = 0.0001, high = 0.05;
+	for(int i = 0; i < 30; i++) {
+		double a = low + (high - low) / 3, b = high - (high - low) / 3;
+		set.scale = a;
+		double la = loss(set, jobs, 0);
+		set.scale = b;
+		double lb = loss(set, jobs, 0);
+		if(la < lb) {
+			high = b;
+		} else {
+			low = a;
+		}
+	}
+	set.scale = (low + high) / 2;
+}
+
+static void writeTable(ostream & out, const char * name, const double * table)
+{
+	out << "static const int " << name << "[64] = {" << endl;
+	for(int rank = 0; rank < 8; rank++) {
+		out << "    ";
+		for(int file = 0; file < 8; file++) {
+			out << (int)floor(table[rank*8 + file] + 0.5);
+			if(rank < 7 || file < 7) {
+				out << ",";
+			}
+		}
+		out << ((rank < 7) ? "" : " };") << endl;
+	}
+	out << endl;
+}
+
+// Writes the parameters out in the form board.cpp keeps them in
+static bool writeParams(const TrainingSet & set, const string & filename)
+{
+	ofstream out(filename.c_str());
+	if(!out) {
+		return false;
+	}
+
+	out << "int Board::pieceValue[Piece::LAST_TYPE + 1] = {";
+	for(int t = 0; t <= Piece::QUEEN; t++) {
+		out << (int)floor(set.params[VALUES + t] + 0.5) << ", ";
+	}
+	out << "0};" << endl << endl;
+
+	writeTable(out, "pawnTable", set.params + PAWN_TABLE);
+	writeTable(out, "knightTable", set.params + KNIGHT_TABLE);
+	writeTable(out, "bishopTable", set.params + BISHOP_TABLE);
+	writeTable(out, "kingTable", set.params + KING_TABLE);
+	writeTable(out, "endKingTable", set.params + END_KING_TABLE);
+	return true;
+}
+
+void printTuneUsage()
+{
+	cerr << "Usage: brutaltune [--epochs=N] [--rate=R] [--threads=N] [--out=FILE] POSITIONS" << endl << endl;
+	cerr << " --epochs=N\t Passes over the positions, 500 by default." << endl;
+	cerr << " --rate=R\t Step size of the optimiser in centipawns, 1 by default." << endl;
+	cerr << " --threads=N\t Number of threads to tune with, 1 by default." << endl;
+	cerr << " --out=FILE\t Where to write the tuned tables, tuned.txt by default." << endl;
+	cerr << " POSITIONS\t Positions with their game results, a FEN and a result" << endl;
+	cerr << "\t\t such as 1-0, 0-1, 1/2-1/2 or [1.0], [0.0], [0.5] per line." << endl;
+	exit(1);
+}
+
+int main(int argc, char * argv[])
+{
+	int epochs = 500, threads = 1;
+	double rate = 1.0;
+	string out = "tuned.txt", positions;
+
+	for(int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		if(arg.substr(0, 9) == "--epochs=") {
+			epochs = atoi(arg.substr(9).c_str());
+		} else if(arg.substr(0, 7) == "--rate=") {
+			rate = atof(arg.substr(7).c_str());
+		} else if(arg.substr(0, 10) == "--threads=") {
+			threads = atoi(arg.substr(10).c_str());
+			if(threads < 1) {
+				printTuneUsage();
+			}
+		} else if(arg.substr(0, 6) == "--out=") {
+			out = arg.substr(6);
+		} else if(arg.substr(0, 2) != "--" && positions.empty()) {
+			positions = arg;
+		} else {
+			printTuneUsage();
+		}
+	}
+	if(positions.empty()) {
+		printTuneUsage();
+	}
+
+	if(SDL_Init(SDL_INIT_TIMER) < 0) {
+		cerr << "Timer initialization failed: " << SDL_GetError() << endl;
+		return 1;
+	}
+	Board::init();
+
+	TrainingSet * set = new TrainingSet();
+	Uint32 start = SDL_GetTicks();
+	initParams(*set);
+	if(!load(*set, positions)) {
+		cerr << "No positions to tune on in " << positions << endl;
+		SDL_Quit();
+		return 1;
+	}
+	cout << "Loaded " << set->samples.size() << " positions in ";
+	cout << SDL_GetTicks() - start << " ms" << endl;
+
+	vector<Job> jobs(threads);
+	fitScale(*set, jobs);
+	double first = loss(*set, jobs, 0);
+	cout << "Scale " << set->scale << ", loss " << first << endl;
+
+	// Adam, which copes with the values and the table entries needing
+	// steps of very different sizes
+	const double BETA1 = 0.9, BETA2 = 0.999, EPSILON = 1e-8;
+	vector<double> grad(NUM_PARAMS), m(NUM_PARAMS, 0.0), v(NUM_PARAMS, 0.0);
+	start = SDL_GetTicks();
+	for(int epoch = 1; epoch <= epochs; epoch++) {
+		double l = loss(*set, jobs, &grad[0]);
+		double c1 = 1.0 - pow(BETA1, epoch), c2 = 1.0 - pow(BETA2, epoch);
+		for(int p = 0; p < NUM_PARAMS; p++) {
+			m[p] = BETA1 * m[p] + (1.0 - BETA1) * grad[p];
+			v[p] = BETA2 * v[p] + (1.0 - BETA2) * grad[p] * grad[p];
+			set->params[p] -= rate * (m[p] / c1) / (sqrt(v[p] / c2) + EPSILON);
+		}
+		if(epoch % 50 == 0 || epoch == epochs) {
+			cout << "Epoch " << epoch << ", loss " << l << ", ";
+			cout << SDL_GetTicks() - start << " ms" << endl;
+		}
+	}
+	cout << "Loss " << first << " to " << loss(*set, jobs, 0) << endl;
+
+	if(!writeParams(*set, out)) {
+		cerr << "Unable to write " << out << endl;
+		SDL_Quit();
+		return 1;
+	}
+	cout << "Tables written to " << out << endl;
+
+	SDL_Quit();
+	return 0;
+}
+
+// End of file tuner.cpp
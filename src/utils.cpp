@@ -6,6 +6,7 @@
  * Authors : Mike Cook, Joe Flint, Neil Pankey
  **************************************************************************/
 
+#include <cstdlib>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -25,25 +26,39 @@ void Quit(int returnCode)
 void printUsage()
 {
 	cerr << "Usage: brutalchess [-h] [-afrs] [-l PLAYER1 PLAYER2] [-p PIECE_SET]\n";
-	cerr <<	"                   [-b BOARD_THEME] [-z SCREEN_RESOLUTION]";
+	cerr <<	"                   [-b BOARD_THEME] [-t THREADS] [-z SCREEN_RESOLUTION]";
 	cerr << endl << endl << endl;
 	cerr << " -a  --animations=on|off\t\t\t Turn off animations, on by default.";
 	cerr << endl << endl;
 	cerr << " -b BOARD_THEME  --board=BOARD_THEME\t\t Set the in-game board. Choices are granite.";
 	cerr << endl << endl;
+	cerr << "     --book=FILE\t\t\t\t\t Polyglot opening book for the Brutal AI, empty for none.";
+	cerr << endl << endl;
+	cerr << "     --egtb=DIR\t\t\t\t\t Directory of endgame tables for the Brutal AI.";
+	cerr << endl << endl;
 	cerr << " -f  --fullscreen=on|off\t\t\t Play in fullscreen mode, windowed by default.";
         cerr << endl << endl;
 	cerr << " -h  --help\t\t\t\t\t Print this help screen.";
 	cerr << endl << endl;
+	cerr << "     --hints=on|off\t\t\t\t Show the move the Brutal AI would play, off by default.";
+	cerr << endl << endl;
 	cerr << " -l PLAYER1 PLAYER2  --player1=PLAYER1\t\t Set your player and opponent. Choices are brutal,\n";
 	cerr << "                     --player2=PLAYER2\t\t faile, human, random, test, xboard.";
 	cerr << endl << endl;
+	cerr << "     --mate=N\t\t\t\t\t Let the Brutal AI look for mates in up to N moves first.";
+	cerr << endl << endl;
+	cerr << "     --net=FILE\t\t\t\t\t Neural network weights for the Brutal AI to evaluate with.";
+	cerr << endl << endl;
 	cerr << " -p PIECE_SET  --pieces=PIECE_SET\t\t Select the piece set. Choices are basic, quake.";
 	cerr << endl << endl;
+	cerr << "     --ponder=on|off\t\t\t\t Let the Brutal AI think on your time, off by default.";
+	cerr << endl << endl;
 	cerr << " -r  --reflections=on|off\t\t\t Turn off reflections, on by default.";
 	cerr << endl << endl;
 	cerr << " -s  --shadows=on|off\t\t\t\t Turn off shadows, on by default.";
 	cerr << endl << endl;
+	cerr << " -t N  --threads=N\t\t\t\t Number of threads the Brutal AI searches with.";
+	cerr << endl << endl;
 	cerr << " -z WIDTHxHEIGHT  --resolution=WIDTHxHEIGHT\t Set screen resolution. Currently support 640x480,\n";
 	cerr << "                                           \t 800x600, 1024x768, 1280x1024, 1400x1050, 1600x1200.";
 	cerr << endl << endl;
@@ -85,6 +100,10 @@ void parseCommandLine(int argc, char* argv[])
 			} else {
 				printUsage();
 			}
+		} else if(args[i].substr(0,7) == "--book=") {
+			opts->bookfile = args[i].substr(7);
+		} else if(args[i].substr(0,7) == "--egtb=") {
+			opts->egtbpath = args[i].substr(7);
 		} else if(args[i].substr(0,13) == "--fullscreen=") {
 			if(args[i].substr(13,3) == "on") {
 				opts->fullscreen = true;
@@ -162,6 +181,13 @@ void parseCommandLine(int argc, char* argv[])
 				printUsage();
 			}
 			i++;
+		} else if(args[i].substr(0,7) == "--mate=") {
+			opts->matesearch = atoi(args[i].substr(7).c_str());
+			if(opts->matesearch < 0) {
+				printUsage();
+			}
+		} else if(args[i].substr(0,6) == "--net=") {
+			opts->netfile = args[i].substr(6);
 		} else if(args[i].substr(0,9) == "--pieces=") {
 			if(args[i].substr(9, args[i].size()) == "basic") {
 				opts->pieces = BASIC;
@@ -172,6 +198,22 @@ void parseCommandLine(int argc, char* argv[])
 			} else {
 				printUsage();
 			}
+		} else if(args[i].substr(0,8) == "--hints=") {
+			if(args[i].substr(8,3) == "on") {
+				opts->hints = true;
+			} else if(args[i].substr(8,4) == "off") {
+				opts->hints = false;
+			} else {
+				printUsage();
+			}
+		} else if(args[i].substr(0,9) == "--ponder=") {
+			if(args[i].substr(9,3) == "on") {
+				opts->ponder = true;
+			} else if(args[i].substr(9,4) == "off") {
+				opts->ponder = false;
+			} else {
+				printUsage();
+			}
 		} else if(args[i].substr(0,14) == "--reflections=") {
 			if(args[i].substr(14,3) == "on") {
 				opts->reflections = true;
@@ -188,6 +230,17 @@ void parseCommandLine(int argc, char* argv[])
 			} else {
 				printUsage();
 			}
+		} else if(args[i] == "-t" && numParams(args,i) == 1) {
+			opts->searchthreads = atoi(args[i+1].c_str());
+			if(opts->searchthreads < 1) {
+				printUsage();
+			}
+			i++;
+		} else if(args[i].substr(0,10) == "--threads=") {
+			opts->searchthreads = atoi(args[i].substr(10).c_str());
+			if(opts->searchthreads < 1) {
+				printUsage();
+			}
 		} else if(args[i] == "-z" && numParams(args,i) == 1) {
 			if(args[i+1] == "640x480") {
 				opts->resolution = r640X480;
@@ -12,8 +12,12 @@
 #include "chessplayer.h"
 
 #include <cassert>
+#include <iomanip>
+#include <poll.h>
 #include <sstream>
 #include <string>
+#include <sys/wait.h>
+#include <unistd.h>
 
 using namespace std;
 
@@ -21,35 +25,86 @@ using namespace std;
 XboardPlayer::XboardPlayer()
 {
 	m_trustworthy = true;
+	m_initialized = false;
+	m_pid = 0;
+	m_turn = Piece::WHITE;
+	m_forced = false;
+	m_level = false;
 }
 
 XboardPlayer::~XboardPlayer()
 {
-	write(m_to[1], "quit\n", 5);
+	if (m_initialized) {
+		write(m_to[1], "quit\n", 5);
+		close(m_to[1]);
+		close(m_from[0]);
+		waitpid(m_pid, NULL, 0);
+	}
 }
 
 void XboardPlayer::newGame()
 {
 	runChessEngine();
+	m_turn = Piece::WHITE;
+	m_forced = false;
+	m_level = false;
 }
 
 void XboardPlayer::loadGame(const ChessGameState& cgs)
 {
+	if (!m_initialized)
+		runChessEngine();
+
+	// Set the position up in force mode so the engine doesn't move for
+	// either side, it is told to go once it's its turn
+	string setup = "force\nsetboard " + cgs.toFEN() + "\n";
+	write(m_to[1], setup.c_str(), setup.size());
+	m_turn = cgs.getTurn();
+	m_forced = true;
 }
 
 void XboardPlayer::startGame()
 {
-	if(m_is_white)
+	if (getColor() == m_turn) {
 		write(m_to[1], "go\n", 3);
+		m_forced = false;
+	}
+}
+
+void XboardPlayer::setClock(unsigned int remaining, unsigned int increment)
+{
+	if (!m_initialized)
+		runChessEngine();
+
+	// The first clock is the whole time control, in minutes and seconds,
+	// after that the engine is told what's left in centiseconds
+	ostringstream out;
+	if (!m_level) {
+		out << "level 0 " << remaining / 60000 << ":" << setw(2) << setfill('0');
+		out << remaining / 1000 % 60 << " " << increment / 1000.0 << "\n";
+		m_level = true;
+	}
+	out << "time " << remaining / 10 << "\n";
+	string command = out.str();
+	write(m_to[1], command.c_str(), command.size());
 }
 
 // Set up gnuchess
 void XboardPlayer::runChessEngine()
 {
+	// One engine per player, shut down the last game's
+	if (m_initialized) {
+		write(m_to[1], "quit\n", 5);
+		close(m_to[1]);
+		close(m_from[0]);
+		waitpid(m_pid, NULL, 0);
+	}
+
 	pipe( m_to );
 	pipe( m_from );
 
-	if (fork() == 0) {
+	m_pid = fork();
+	if (m_pid == 0) {
 		// Child Process
 		nice( 20 );
 		dup2( m_to[0], 0 );
@@ -59,7 +114,10 @@ void XboardPlayer::runChessEngine()
 		close( m_from[0] );
 		execvp( "gnuchess", NULL );
 		cerr << "Couldn't run gnuchess" << endl;
+		_exit(1);
 	}
+	close( m_to[0] );
+	close( m_from[1] );
 	write( m_to[1], "xboard\n", 7);
 	m_initialized = true;
 }
@@ -73,6 +131,14 @@ void XboardPlayer::think(const ChessGameState & cgs)
 	string output;
 	char c;
 	while ( output.substr(0, 11) != "My move is:") {
+		// Wake up now and then to see if the game has moved on without us
+		pollfd pfd = { m_from[0], POLLIN, 0 };
+		while (!m_interrupted && poll(&pfd, 1, 50) == 0)
+			;
+		if (m_interrupted) {
+			m_move.invalidate();
+			return;
+		}
 		output = "";
 		while ( read( m_from[0], &c, 1 ) ) {
 			if ( c == '\n' )
@@ -127,6 +193,12 @@ void XboardPlayer::opponentMove(const BoardMove & move, const ChessGameState & c
 	cout << movestr << endl;
 
 	write( m_to[1], movestr.c_str(), characters);
+
+	// Out of force mode, now the engine has a move to answer
+	if (m_forced) {
+		write( m_to[1], "go\n", 3);
+		m_forced = false;
+	}
 }
 
 void XboardPlayer::undoMove()